@@ -10,12 +10,14 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 
 // Opaque types for Swift interop
 struct llama_model;
 struct llama_context;
 struct llama_vocab;
 struct llama_sampler;
+struct llama_wrapper_lora;
 
 // Token type
 typedef int32_t llama_token;
@@ -57,6 +59,58 @@ void llama_wrapper_free_model(struct llama_model *model);
 /// @return Number of characters written
 int32_t llama_wrapper_model_desc(struct llama_model *model, char *buf, size_t buf_size);
 
+// MARK: - Model Inspection
+
+/// GGUF metadata read from the file header, without loading any tensors
+struct llama_model_info {
+    char architecture[32];   // general.architecture (e.g. "qwen2")
+    char name[128];          // general.name
+    char dominant_type[16];  // Tensor type holding the most bytes (e.g. "q4_K")
+    int32_t file_type;       // general.file_type (-1 if absent)
+    int32_t n_tensor_types;  // Number of distinct tensor types
+    int64_t n_tensors;       // Number of tensors
+    int64_t n_params;        // Total parameter count
+    uint64_t tensor_bytes;   // Total tensor data size
+    uint32_t n_ctx_train;    // Training context length
+    uint32_t n_embd;         // Embedding size
+    uint32_t n_ff;           // Feed-forward size
+    uint32_t n_layer;        // Number of layers
+    uint32_t n_head;         // Attention heads
+    uint32_t n_head_kv;      // KV heads (GQA)
+    uint32_t n_embd_head_k;  // Key size per head
+    uint32_t n_embd_head_v;  // Value size per head
+    int32_t n_vocab;         // Vocab size
+    bool has_chat_template;  // tokenizer.chat_template present
+};
+
+/// Predicted resident memory for a model and context configuration
+struct llama_memory_estimate {
+    uint64_t weights_bytes;  // Model weights (mmap is disabled, so fully resident)
+    uint64_t kv_cache_bytes; // F16 KV cache
+    uint64_t compute_bytes;  // Compute and output buffers
+    uint64_t total_bytes;
+};
+
+/// Read model metadata from a GGUF header without loading tensors
+/// @param path_model Path to the .gguf model file
+/// @param info Filled with the model metadata
+/// @param chat_template Buffer for the chat template (can be NULL, truncated if too small)
+/// @param chat_template_size Buffer size
+/// @return 0 on success, non-zero on error
+int32_t llama_wrapper_inspect_model(const char *path_model,
+                                    struct llama_model_info *info,
+                                    char *chat_template,
+                                    size_t chat_template_size);
+
+/// Predict resident memory for a model with the context options used by llama_wrapper_new_context
+/// @param info Model metadata from llama_wrapper_inspect_model
+/// @param n_ctx Context window size (0 for the llama_wrapper_new_context default)
+/// @param n_seq_max Number of parallel sequences (0 for 1)
+/// @return The memory estimate
+struct llama_memory_estimate llama_wrapper_estimate_memory(const struct llama_model_info *info,
+                                                           uint32_t n_ctx,
+                                                           uint32_t n_seq_max);
+
 // MARK: - Context Management
 
 /// Create a context from a loaded model
@@ -76,6 +130,36 @@ void llama_wrapper_free_context(struct llama_context *ctx);
 /// Get the vocab from a model
 struct llama_vocab *llama_wrapper_get_vocab(struct llama_model *model);
 
+// MARK: - LoRA Adapters
+
+/// Load a LoRA adapter (load once, then attach to contexts as needed)
+/// @param model The base model the adapter was trained against
+/// @param path_lora Path to the adapter .gguf file
+/// @return Pointer to adapter or NULL on error (including a base model mismatch)
+struct llama_wrapper_lora *llama_wrapper_lora_load(struct llama_model *model, const char *path_lora);
+
+/// Free an adapter (must be called before freeing its model)
+void llama_wrapper_lora_free(struct llama_wrapper_lora *lora);
+
+/// Get the size of an adapter's .gguf file on disk in bytes
+/// Adapter tensors are loaded whole, so this approximates (but does not measure) their memory
+size_t llama_wrapper_lora_file_size(const struct llama_wrapper_lora *lora);
+
+/// Attach an adapter to a context (takes effect on the next decode)
+/// Clear the KV cache afterwards - cached keys/values were computed without it
+/// @param ctx The context
+/// @param lora The adapter
+/// @param scale Adapter strength (1.0 = as trained)
+/// @return 0 on success, non-zero on error
+int32_t llama_wrapper_lora_attach(struct llama_context *ctx, struct llama_wrapper_lora *lora, float scale);
+
+/// Detach an adapter from a context
+/// @return 0 on success, -1 if the adapter was not attached
+int32_t llama_wrapper_lora_detach(struct llama_context *ctx, struct llama_wrapper_lora *lora);
+
+/// Detach all adapters from a context
+void llama_wrapper_lora_detach_all(struct llama_context *ctx);
+
 // MARK: - Tokenization
 
 /// Tokenize text
@@ -129,30 +213,163 @@ struct llama_sampler_config {
 /// Get default sampler config
 struct llama_sampler_config llama_wrapper_default_sampler_config(void);
 
+/// A required note section for schema-constrained generation
+struct llama_note_section {
+    const char *header;    // Section header without the colon (e.g. "Subjective")
+    int32_t max_tokens;    // Token budget for the section (0 = no limit)
+};
+
+/// Handling of <think>...</think> reasoning blocks (DeepSeek-R1 style models)
+/// Models without <think> tokens in their vocab always behave as KEEP
+enum llama_reasoning_mode {
+    LLAMA_REASONING_KEEP = 0,   // Pass reasoning through to the output unchanged
+    LLAMA_REASONING_SUPPRESS,   // Prefill a closed think block and ban reopening it
+    LLAMA_REASONING_BUDGET,     // Cap reasoning at reasoning_budget tokens, strip it from the output
+    LLAMA_REASONING_STRIP       // Let the model reason freely, strip it from the output
+};
+
+/// Output constraints for generation
+/// Sections are emitted in order as "Header:" followed by one or more lines
+/// and closed by a blank line. Generation stops once the last section closes.
+/// Reasoning tokens never count towards the section budgets, and only count
+/// towards max_tokens in LLAMA_REASONING_KEEP.
+struct llama_generation_options {
+    const char *grammar;                        // GBNF grammar (NULL = compile from sections)
+    const char *grammar_root;                   // Root rule name (NULL = "root")
+    const struct llama_note_section *sections;  // Required sections in order (can be NULL)
+    int32_t n_sections;                         // Number of sections
+    enum llama_reasoning_mode reasoning;        // Reasoning handling
+    int32_t reasoning_budget;                   // Max reasoning tokens for LLAMA_REASONING_BUDGET
+};
+
+/// Statistics for a single generation
+struct llama_generation_stats {
+    int32_t n_prompt_tokens;     // Prompt tokens, including any think-block prefill
+    int32_t n_generated_tokens;  // All generated tokens, including reasoning
+    int32_t n_reasoning_tokens;  // Tokens inside the think block
+    double t_prompt_ms;          // Prompt processing time
+    double t_generate_ms;        // Generation time
+};
+
+/// Compile a GBNF grammar from a section schema
+/// @param sections Required sections in order
+/// @param n_sections Number of sections
+/// @param buf Buffer to store the grammar
+/// @param buf_size Buffer size
+/// @return Length of the grammar (negative if the buffer is too small)
+int32_t llama_wrapper_build_section_grammar(const struct llama_note_section *sections,
+                                             int32_t n_sections,
+                                             char *buf,
+                                             size_t buf_size);
+
 /// Generate text from a prompt
 /// @param ctx The context
 /// @param vocab The vocabulary
 /// @param prompt The prompt text
 /// @param max_tokens Maximum number of tokens to generate
 /// @param config Sampler configuration
+/// @param options Grammar and section constraints (can be NULL)
 /// @param token_callback Called for each generated token (can be NULL)
 /// @param user_data User data passed to callback
 /// @param output_buffer Buffer to store full output
 /// @param output_buffer_size Size of output buffer
-/// @return Number of tokens generated (negative on error)
+/// @param stats Filled with generation statistics (can be NULL)
+/// @return Number of tokens generated, including reasoning (negative on error)
 int32_t llama_wrapper_generate(struct llama_context *ctx,
                                 struct llama_vocab *vocab,
                                 const char *prompt,
                                 int32_t max_tokens,
                                 struct llama_sampler_config config,
+                                const struct llama_generation_options *options,
                                 llama_wrapper_token_callback token_callback,
                                 void *user_data,
                                 char *output_buffer,
-                                size_t output_buffer_size);
+                                size_t output_buffer_size,
+                                struct llama_generation_stats *stats);
 
 /// Clear the KV cache
 void llama_wrapper_clear_kv_cache(struct llama_context *ctx);
 
+// MARK: - Batch Jobs
+
+/// State of a queued batch job
+enum llama_batch_job_status {
+    LLAMA_BATCH_JOB_PENDING = 0,  // Not run (queued, or the run was cancelled)
+    LLAMA_BATCH_JOB_DONE,         // Output and stats are filled in
+    LLAMA_BATCH_JOB_FAILED        // Prompt too long for the context, or a decode error
+};
+
+/// One prompt to generate in a batch run
+struct llama_batch_job {
+    // Inputs
+    const char *prompt;                              // Full prompt text
+    int32_t max_tokens;                              // Maximum answer tokens
+    const struct llama_generation_options *options;  // Grammar and section constraints (can be NULL)
+    char *output_buffer;                             // Buffer to store the output
+    size_t output_buffer_size;                       // Size of output buffer
+
+    // Results
+    enum llama_batch_job_status status;
+    struct llama_generation_stats stats;             // Prompt time is measured from admission
+    double t_wait_ms;                                // Queued time before the job was admitted
+    double t_latency_ms;                             // From the start of the run to completion
+};
+
+/// Aggregate statistics for a batch run
+struct llama_batch_run_stats {
+    int32_t n_jobs_done;
+    int32_t n_jobs_failed;
+    int32_t n_decode_calls;        // llama_decode calls shared by all sequences
+    int64_t n_prompt_tokens;
+    int64_t n_generated_tokens;    // Including reasoning
+    double t_total_ms;
+    double prompt_tokens_per_s;    // Over the whole run
+    double generated_tokens_per_s; // Over the whole run
+};
+
+/// Called on the calling thread as each job finishes or fails
+/// @return false to cancel the run (remaining jobs stay pending)
+typedef bool (*llama_wrapper_batch_job_callback)(int32_t job_index,
+                                                 const struct llama_batch_job *job,
+                                                 void *user_data);
+
+/// Create a context that runs up to n_seq_max sequences in parallel
+/// All sequences share one pool of n_ctx KV cells
+/// @param model The loaded model
+/// @param n_ctx Total KV cells (0 for the llama_wrapper_new_context default per sequence)
+/// @param n_seq_max Number of parallel sequences
+/// @param n_threads Number of threads for generation
+/// @param n_threads_batch Number of threads for batch processing
+/// @return Pointer to context or NULL on error
+struct llama_context *llama_wrapper_new_batch_context(struct llama_model *model,
+                                                       uint32_t n_ctx,
+                                                       uint32_t n_seq_max,
+                                                       int32_t n_threads,
+                                                       int32_t n_threads_batch);
+
+/// Run a queue of jobs with continuous batching
+/// Jobs are admitted in order as soon as a sequence and enough KV cells are free,
+/// and all running sequences are decoded together, one token each per step.
+/// LLAMA_REASONING_STRIP think blocks are closed after max_tokens so each job fits its KV reservation.
+/// Clears the KV cache before and after the run.
+/// @param ctx A context from llama_wrapper_new_batch_context
+/// @param vocab The vocabulary
+/// @param jobs Jobs to run (results are written back)
+/// @param n_jobs Number of jobs
+/// @param config Sampler configuration (shared by all jobs)
+/// @param job_callback Called as each job completes (can be NULL)
+/// @param user_data User data passed to callback
+/// @param stats Filled with aggregate statistics (can be NULL)
+/// @return Number of jobs completed (negative on error)
+int32_t llama_wrapper_run_batch_jobs(struct llama_context *ctx,
+                                     struct llama_vocab *vocab,
+                                     struct llama_batch_job *jobs,
+                                     int32_t n_jobs,
+                                     struct llama_sampler_config config,
+                                     llama_wrapper_batch_job_callback job_callback,
+                                     void *user_data,
+                                     struct llama_batch_run_stats *stats);
+
 // MARK: - Batch Processing
 
 /// Process a batch of tokens (prompt processing)
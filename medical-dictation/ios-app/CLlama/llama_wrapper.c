@@ -7,11 +7,15 @@
 
 #include "include/llama_wrapper.h"
 #include "llama.h"
+#include "ggml.h"
+#include "gguf.h"
 
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <math.h>
 #include <time.h>
+#include <sys/stat.h>
 
 // MARK: - Backend Management
 
@@ -61,6 +65,136 @@ int32_t llama_wrapper_model_desc(struct llama_model *model, char *buf, size_t bu
     return llama_model_desc(model, buf, buf_size);
 }
 
+// MARK: - Model Inspection
+
+// Context options used by llama_wrapper_new_context
+#define WRAPPER_DEFAULT_N_CTX 2048
+#define WRAPPER_N_UBATCH 256
+
+static void copy_gguf_str(const struct gguf_context *gctx, const char *key, char *buf, size_t buf_size) {
+    int64_t id = gguf_find_key(gctx, key);
+    if (id < 0 || gguf_get_kv_type(gctx, id) != GGUF_TYPE_STRING || buf_size == 0) return;
+    snprintf(buf, buf_size, "%s", gguf_get_val_str(gctx, id));
+}
+
+/// Read an unsigned integer for "<arch>.<suffix>" (fallback if absent or per-layer)
+static uint32_t get_arch_u32(const struct gguf_context *gctx, const char *arch, const char *suffix, uint32_t fallback) {
+    char key[128];
+    snprintf(key, sizeof(key), "%s.%s", arch, suffix);
+    
+    int64_t id = gguf_find_key(gctx, key);
+    if (id < 0) return fallback;
+    
+    switch (gguf_get_kv_type(gctx, id)) {
+        case GGUF_TYPE_UINT32: return gguf_get_val_u32(gctx, id);
+        case GGUF_TYPE_INT32:  return (uint32_t)gguf_get_val_i32(gctx, id);
+        case GGUF_TYPE_UINT64: return (uint32_t)gguf_get_val_u64(gctx, id);
+        default:               return fallback;
+    }
+}
+
+int32_t llama_wrapper_inspect_model(const char *path_model,
+                                    struct llama_model_info *info,
+                                    char *chat_template,
+                                    size_t chat_template_size) {
+    if (!path_model || !info) return -1;
+    memset(info, 0, sizeof(*info));
+    
+    // No ggml context - only the metadata and tensor infos are read
+    struct gguf_init_params params = { .no_alloc = true, .ctx = NULL };
+    struct gguf_context *gctx = gguf_init_from_file(path_model, params);
+    if (!gctx) return -1;
+    
+    copy_gguf_str(gctx, "general.architecture", info->architecture, sizeof(info->architecture));
+    copy_gguf_str(gctx, "general.name", info->name, sizeof(info->name));
+    
+    int64_t ftype_id = gguf_find_key(gctx, "general.file_type");
+    info->file_type = ftype_id >= 0 && gguf_get_kv_type(gctx, ftype_id) == GGUF_TYPE_UINT32
+                    ? (int32_t)gguf_get_val_u32(gctx, ftype_id) : -1;
+    
+    const char *arch = info->architecture;
+    info->n_ctx_train = get_arch_u32(gctx, arch, "context_length", 0);
+    info->n_embd = get_arch_u32(gctx, arch, "embedding_length", 0);
+    info->n_ff = get_arch_u32(gctx, arch, "feed_forward_length", 0);
+    info->n_layer = get_arch_u32(gctx, arch, "block_count", 0);
+    info->n_head = get_arch_u32(gctx, arch, "attention.head_count", 0);
+    info->n_head_kv = get_arch_u32(gctx, arch, "attention.head_count_kv", info->n_head);
+    
+    uint32_t n_embd_head = info->n_head > 0 ? info->n_embd / info->n_head : 0;
+    info->n_embd_head_k = get_arch_u32(gctx, arch, "attention.key_length", n_embd_head);
+    info->n_embd_head_v = get_arch_u32(gctx, arch, "attention.value_length", n_embd_head);
+    
+    int64_t tokens_id = gguf_find_key(gctx, "tokenizer.ggml.tokens");
+    if (tokens_id >= 0 && gguf_get_kv_type(gctx, tokens_id) == GGUF_TYPE_ARRAY) {
+        info->n_vocab = (int32_t)gguf_get_arr_n(gctx, tokens_id);
+    }
+    
+    int64_t template_id = gguf_find_key(gctx, "tokenizer.chat_template");
+    info->has_chat_template = template_id >= 0;
+    if (chat_template && chat_template_size > 0) {
+        chat_template[0] = '\0';
+        copy_gguf_str(gctx, "tokenizer.chat_template", chat_template, chat_template_size);
+    }
+    
+    // Tensor totals, broken down by type
+    uint64_t bytes_by_type[GGML_TYPE_COUNT] = {0};
+    info->n_tensors = gguf_get_n_tensors(gctx);
+    
+    for (int64_t i = 0; i < info->n_tensors; i++) {
+        enum ggml_type type = gguf_get_tensor_type(gctx, i);
+        size_t size = gguf_get_tensor_size(gctx, i);
+        
+        info->tensor_bytes += size;
+        info->n_params += (int64_t)(size / ggml_type_size(type)) * ggml_blck_size(type);
+        if ((int)type >= 0 && type < GGML_TYPE_COUNT) {
+            bytes_by_type[type] += size;
+        }
+    }
+    
+    int dominant = -1;
+    for (int t = 0; t < GGML_TYPE_COUNT; t++) {
+        if (bytes_by_type[t] == 0) continue;
+        info->n_tensor_types++;
+        if (dominant < 0 || bytes_by_type[t] > bytes_by_type[dominant]) {
+            dominant = t;
+        }
+    }
+    if (dominant >= 0) {
+        snprintf(info->dominant_type, sizeof(info->dominant_type), "%s", ggml_type_name((enum ggml_type)dominant));
+    }
+    
+    gguf_free(gctx);
+    return 0;
+}
+
+struct llama_memory_estimate llama_wrapper_estimate_memory(const struct llama_model_info *info,
+                                                           uint32_t n_ctx,
+                                                           uint32_t n_seq_max) {
+    struct llama_memory_estimate estimate = {0};
+    if (!info) return estimate;
+    
+    uint64_t ctx_size = n_ctx > 0 ? n_ctx : WRAPPER_DEFAULT_N_CTX;
+    uint64_t n_seq = n_seq_max > 0 ? n_seq_max : 1;
+    uint64_t n_ubatch = WRAPPER_N_UBATCH < ctx_size ? WRAPPER_N_UBATCH : ctx_size;
+    
+    estimate.weights_bytes = info->tensor_bytes;
+    
+    // F16 keys and values for every layer and cell
+    uint64_t kv_per_cell = (uint64_t)info->n_head_kv * (info->n_embd_head_k + info->n_embd_head_v);
+    estimate.kv_cache_bytes = ctx_size * info->n_layer * kv_per_cell * sizeof(uint16_t);
+    
+    // Largest F32 intermediates of one ubatch: attention scores, feed-forward and logits,
+    // plus the output buffer holding one row of logits per sequence
+    uint64_t kq = n_ubatch * ctx_size * info->n_head;
+    uint64_t ff = n_ubatch * (info->n_ff > 0 ? info->n_ff : 4ull * info->n_embd);
+    uint64_t logits = n_ubatch * (uint64_t)info->n_vocab;
+    uint64_t output = n_seq * (uint64_t)info->n_vocab;
+    estimate.compute_bytes = (kq + ff + logits + output) * sizeof(float);
+    
+    estimate.total_bytes = estimate.weights_bytes + estimate.kv_cache_bytes + estimate.compute_bytes;
+    return estimate;
+}
+
 // MARK: - Context Management
 
 struct llama_context *llama_wrapper_new_context(struct llama_model *model,
@@ -70,9 +204,9 @@ struct llama_context *llama_wrapper_new_context(struct llama_model *model,
     if (!model) return NULL;
     
     struct llama_context_params params = llama_context_default_params();
-    params.n_ctx = n_ctx > 0 ? n_ctx : 2048;  // Reduced default for iOS
-    params.n_batch = 256;                      // Smaller batches
-    params.n_ubatch = 256;
+    params.n_ctx = n_ctx > 0 ? n_ctx : WRAPPER_DEFAULT_N_CTX;  // Reduced default for iOS
+    params.n_batch = WRAPPER_N_UBATCH;                         // Smaller batches
+    params.n_ubatch = WRAPPER_N_UBATCH;
     params.n_threads = n_threads > 0 ? n_threads : 2;  // Fewer threads
     params.n_threads_batch = n_threads_batch > 0 ? n_threads_batch : params.n_threads;
     params.offload_kqv = false;                // Don't offload KQV to save memory
@@ -91,6 +225,61 @@ struct llama_vocab *llama_wrapper_get_vocab(struct llama_model *model) {
     return llama_model_get_vocab(model);
 }
 
+// MARK: - LoRA Adapters
+
+struct llama_wrapper_lora {
+    struct llama_adapter_lora *adapter;
+    size_t n_file_bytes;
+};
+
+struct llama_wrapper_lora *llama_wrapper_lora_load(struct llama_model *model, const char *path_lora) {
+    if (!model || !path_lora) return NULL;
+    
+    struct stat st;
+    if (stat(path_lora, &st) != 0) return NULL;
+    
+    struct llama_adapter_lora *adapter = llama_adapter_lora_init(model, path_lora);
+    if (!adapter) return NULL;
+    
+    struct llama_wrapper_lora *lora = (struct llama_wrapper_lora *)malloc(sizeof(*lora));
+    if (!lora) {
+        llama_adapter_lora_free(adapter);
+        return NULL;
+    }
+    
+    lora->adapter = adapter;
+    lora->n_file_bytes = (size_t)st.st_size;
+    return lora;
+}
+
+void llama_wrapper_lora_free(struct llama_wrapper_lora *lora) {
+    if (lora) {
+        llama_adapter_lora_free(lora->adapter);
+        free(lora);
+    }
+}
+
+size_t llama_wrapper_lora_file_size(const struct llama_wrapper_lora *lora) {
+    if (!lora) return 0;
+    return lora->n_file_bytes;
+}
+
+int32_t llama_wrapper_lora_attach(struct llama_context *ctx, struct llama_wrapper_lora *lora, float scale) {
+    if (!ctx || !lora) return -1;
+    return llama_set_adapter_lora(ctx, lora->adapter, scale);
+}
+
+int32_t llama_wrapper_lora_detach(struct llama_context *ctx, struct llama_wrapper_lora *lora) {
+    if (!ctx || !lora) return -1;
+    return llama_rm_adapter_lora(ctx, lora->adapter);
+}
+
+void llama_wrapper_lora_detach_all(struct llama_context *ctx) {
+    if (ctx) {
+        llama_clear_adapter_lora(ctx);
+    }
+}
+
 // MARK: - Tokenization
 
 int32_t llama_wrapper_tokenize(struct llama_vocab *vocab,
@@ -148,15 +337,64 @@ llama_token llama_wrapper_get_eos_token(struct llama_vocab *vocab) {
 
 // MARK: - Sampler Helpers
 
-static struct llama_sampler *create_sampler(struct llama_vocab *vocab, struct llama_sampler_config config) {
-    struct llama_sampler_chain_params sparams = llama_sampler_chain_default_params();
-    struct llama_sampler *smpl = llama_sampler_chain_init(sparams);
-    
+/// Sampler chain with an optional grammar that is only checked against the chosen token
+/// Running the grammar over the full vocab every step is expensive, so the chain samples
+/// first and the grammar only filters the candidates when it rejects the pick.
+struct wrapper_sampler {
+    struct llama_sampler *chain;    // Logit bias, penalties, top-k/p, min-p, temperature, dist
+    struct llama_sampler *grammar;  // NULL when unconstrained
+    llama_token_data *candidates;   // Scratch array of n_vocab entries
+    int32_t n_vocab;
+};
+
+static void free_sampler(struct wrapper_sampler *smpl) {
+    if (!smpl) return;
+    if (smpl->grammar) llama_sampler_free(smpl->grammar);
+    if (smpl->chain) llama_sampler_free(smpl->chain);
+    free(smpl->candidates);
+    free(smpl);
+}
+
+static struct wrapper_sampler *create_sampler(struct llama_vocab *vocab,
+                                              struct llama_sampler_config config,
+                                              const char *grammar,
+                                              const char *grammar_root,
+                                              const llama_logit_bias *logit_bias,
+                                              int32_t n_logit_bias) {
+    struct wrapper_sampler *smpl = (struct wrapper_sampler *)calloc(1, sizeof(*smpl));
     if (!smpl) return NULL;
     
+    smpl->n_vocab = llama_vocab_n_tokens(vocab);
+    smpl->candidates = (llama_token_data *)malloc(smpl->n_vocab * sizeof(llama_token_data));
+    smpl->chain = llama_sampler_chain_init(llama_sampler_chain_default_params());
+    if (!smpl->candidates || !smpl->chain) {
+        free_sampler(smpl);
+        return NULL;
+    }
+    
+    // Grammar is kept out of the chain and applied lazily in sampler_sample
+    if (grammar) {
+        smpl->grammar = llama_sampler_init_grammar(vocab, grammar, grammar_root ? grammar_root : "root");
+        if (!smpl->grammar) {
+            free_sampler(smpl);
+            return NULL;
+        }
+    }
+    
+    struct llama_sampler *chain = smpl->chain;
+    
+    // Add logit bias (used to ban tokens outright)
+    if (logit_bias && n_logit_bias > 0) {
+        llama_sampler_chain_add(chain, llama_sampler_init_logit_bias(
+            smpl->n_vocab,
+            n_logit_bias,
+            logit_bias
+        ));
+    }
+    
     // Add repetition penalty if configured
     if (config.repeat_penalty != 1.0f && config.repeat_last_n > 0) {
-        llama_sampler_chain_add(smpl, llama_sampler_init_penalties(
+        llama_sampler_chain_add(chain, llama_sampler_init_penalties(
             config.repeat_last_n,
             config.repeat_penalty,
             0.0f,  // freq penalty
@@ -166,30 +404,73 @@ static struct llama_sampler *create_sampler(struct llama_vocab *vocab, struct ll
     
     // Add top-k sampling
     if (config.top_k > 0) {
-        llama_sampler_chain_add(smpl, llama_sampler_init_top_k(config.top_k));
+        llama_sampler_chain_add(chain, llama_sampler_init_top_k(config.top_k));
     }
     
     // Add top-p (nucleus) sampling
     if (config.top_p < 1.0f) {
-        llama_sampler_chain_add(smpl, llama_sampler_init_top_p(config.top_p, 1));
+        llama_sampler_chain_add(chain, llama_sampler_init_top_p(config.top_p, 1));
     }
     
     // Add min-p sampling
     if (config.min_p > 0.0f) {
-        llama_sampler_chain_add(smpl, llama_sampler_init_min_p(config.min_p, 1));
+        llama_sampler_chain_add(chain, llama_sampler_init_min_p(config.min_p, 1));
     }
     
     // Add temperature
     float temp = config.temperature > 0.0f ? config.temperature : 0.8f;
-    llama_sampler_chain_add(smpl, llama_sampler_init_temp(temp));
+    llama_sampler_chain_add(chain, llama_sampler_init_temp(temp));
     
     // Add distribution sampler (always last)
     uint32_t seed = config.seed != 0 ? config.seed : (uint32_t)time(NULL);
-    llama_sampler_chain_add(smpl, llama_sampler_init_dist(seed));
+    llama_sampler_chain_add(chain, llama_sampler_init_dist(seed));
     
     return smpl;
 }
 
+static void fill_candidates(struct wrapper_sampler *smpl, struct llama_context *ctx, int32_t idx,
+                            llama_token_data_array *cur_p) {
+    const float *logits = llama_get_logits_ith(ctx, idx);
+    for (int32_t i = 0; i < smpl->n_vocab; i++) {
+        smpl->candidates[i] = (llama_token_data){ i, logits[i], 0.0f };
+    }
+    *cur_p = (llama_token_data_array){ smpl->candidates, (size_t)smpl->n_vocab, -1, false };
+}
+
+/// Record a token that was sampled or forced
+static void sampler_accept(struct wrapper_sampler *smpl, llama_token token) {
+    if (smpl->grammar) {
+        llama_sampler_accept(smpl->grammar, token);
+    }
+    llama_sampler_accept(smpl->chain, token);
+}
+
+/// Sample from the logits at idx (-1 for the last) and accept the token
+static llama_token sampler_sample(struct wrapper_sampler *smpl, struct llama_context *ctx, int32_t idx) {
+    llama_token_data_array cur_p;
+    fill_candidates(smpl, ctx, idx, &cur_p);
+    llama_sampler_apply(smpl->chain, &cur_p);
+    llama_token token = cur_p.data[cur_p.selected].id;
+    
+    if (smpl->grammar) {
+        // Check only the chosen token against the grammar
+        llama_token_data single = { token, 1.0f, 0.0f };
+        llama_token_data_array single_p = { &single, 1, -1, false };
+        llama_sampler_apply(smpl->grammar, &single_p);
+        
+        // Rejected - resample with the grammar filtering the full vocab first
+        if (single.logit == -INFINITY) {
+            fill_candidates(smpl, ctx, idx, &cur_p);
+            llama_sampler_apply(smpl->grammar, &cur_p);
+            llama_sampler_apply(smpl->chain, &cur_p);
+            token = cur_p.data[cur_p.selected].id;
+        }
+    }
+    
+    sampler_accept(smpl, token);
+    return token;
+}
+
 struct llama_sampler_config llama_wrapper_default_sampler_config(void) {
     struct llama_sampler_config config = {
         .temperature = 0.7f,
@@ -203,6 +484,154 @@ struct llama_sampler_config llama_wrapper_default_sampler_config(void) {
     return config;
 }
 
+// MARK: - Section Constraints
+
+static int32_t append_grammar(char *buf, size_t buf_size, size_t pos, const char *str) {
+    size_t len = strlen(str);
+    if (buf && pos + len < buf_size) {
+        memcpy(buf + pos, str, len);
+        buf[pos + len] = '\0';
+    }
+    return (int32_t)len;
+}
+
+int32_t llama_wrapper_build_section_grammar(const struct llama_note_section *sections,
+                                             int32_t n_sections,
+                                             char *buf,
+                                             size_t buf_size) {
+    if (!sections || n_sections <= 0) return 0;
+    
+    size_t pos = 0;
+    char rule[32];
+    
+    // root ::= section-0 section-1 ...
+    pos += append_grammar(buf, buf_size, pos, "root ::=");
+    for (int32_t i = 0; i < n_sections; i++) {
+        snprintf(rule, sizeof(rule), " section-%d", i);
+        pos += append_grammar(buf, buf_size, pos, rule);
+    }
+    pos += append_grammar(buf, buf_size, pos, "\n");
+    
+    // section-N ::= "Header:" body
+    for (int32_t i = 0; i < n_sections; i++) {
+        snprintf(rule, sizeof(rule), "section-%d ::= \"", i);
+        pos += append_grammar(buf, buf_size, pos, rule);
+        
+        const char *header = sections[i].header ? sections[i].header : "";
+        for (const char *c = header; *c; c++) {
+            char escaped[3] = {0};
+            if (*c == '"' || *c == '\\') {
+                escaped[0] = '\\';
+                escaped[1] = *c;
+            } else {
+                escaped[0] = *c;
+            }
+            pos += append_grammar(buf, buf_size, pos, escaped);
+        }
+        pos += append_grammar(buf, buf_size, pos, ":\" body\n");
+    }
+    
+    // A section holds at least one non-empty line and is closed by a blank line
+    pos += append_grammar(buf, buf_size, pos,
+                          "body ::= [ \\t]* \"\\n\"? line+ \"\\n\"\n"
+                          "line ::= [^\\n]+ \"\\n\"\n");
+    
+    if (!buf || pos >= buf_size) {
+        return -(int32_t)(pos + 1);
+    }
+    return (int32_t)pos;
+}
+
+/// Tracks section progress from the generated text, following the section grammar:
+/// body ::= [ \t]* "\n"? line+ "\n" with line ::= [^\n]+ "\n"
+struct section_tracker {
+    const struct llama_note_section *sections;
+    int32_t n_sections;
+    int32_t current;    // Index of the section being written
+    int32_t n_tokens;   // Tokens spent in the current section
+    int32_t n_chars;    // Characters emitted in the current section
+    int32_t line_len;   // Characters on the current line after the header
+    int32_t n_lines;    // Completed (non-empty) lines after the header
+    bool closed;        // Final section has been closed
+};
+
+/// A newline is valid here: it ends a non-empty line or closes a section with at least one line
+static bool section_tracker_has_text(const struct section_tracker *t) {
+    return t->line_len > 0 || t->n_lines > 0;
+}
+
+static void section_tracker_observe(struct section_tracker *t, const char *piece, int32_t len) {
+    for (int32_t i = 0; i < len && !t->closed; i++) {
+        char c = piece[i];
+        t->n_chars++;
+        
+        const char *header = t->sections[t->current].header;
+        int32_t header_len = header ? (int32_t)strlen(header) + 1 : 1;
+        if (t->n_chars <= header_len) continue;
+        
+        if (c != '\n') {
+            t->line_len++;
+        } else if (t->line_len > 0) {
+            t->n_lines++;
+            t->line_len = 0;
+        } else if (t->n_lines > 0) {
+            // An empty line after at least one line closes the section
+            if (t->current == t->n_sections - 1) {
+                t->closed = true;
+            } else {
+                t->current++;
+                t->n_tokens = 0;
+                t->n_chars = 0;
+                t->n_lines = 0;
+            }
+        }
+    }
+}
+
+static bool section_tracker_over_budget(const struct section_tracker *t) {
+    int32_t budget = t->sections[t->current].max_tokens;
+    return budget > 0 && t->n_tokens >= budget && section_tracker_has_text(t);
+}
+
+// MARK: - Reasoning Control
+
+/// Look up a token that the vocab encodes as a single special token
+/// @return The token, or -1 if the text is not a single token
+static llama_token lookup_special_token(struct llama_vocab *vocab, const char *text) {
+    llama_token tokens[4];
+    int32_t n = llama_tokenize(vocab, text, (int32_t)strlen(text), tokens, 4, false, true);
+    return n == 1 ? tokens[0] : -1;
+}
+
+/// Tokenize text (with special tokens) and append it to a token array
+/// @return The new number of tokens (negative on error)
+static int32_t append_special_tokens(struct llama_vocab *vocab,
+                                     const char *text,
+                                     llama_token **tokens,
+                                     int32_t n_tokens) {
+    int32_t len = (int32_t)strlen(text);
+    int32_t n_extra = -llama_tokenize(vocab, text, len, NULL, 0, false, true);
+    if (n_extra <= 0) return n_tokens;
+    
+    llama_token *grown = (llama_token *)realloc(*tokens, (n_tokens + n_extra) * sizeof(llama_token));
+    if (!grown) return -1;
+    *tokens = grown;
+    
+    if (llama_tokenize(vocab, text, len, grown + n_tokens, n_extra, false, true) != n_extra) return -1;
+    return n_tokens + n_extra;
+}
+
+/// Check whether the prompt leaves a think block open (chat templates may follow <think> with "\n")
+static bool prompt_opens_think(const llama_token *tokens, int32_t n_tokens,
+                               llama_token think_open, llama_token think_close) {
+    const int32_t n_tail = 4;
+    for (int32_t i = n_tokens - 1; i >= 0 && i >= n_tokens - n_tail; i--) {
+        if (tokens[i] == think_close) return false;
+        if (tokens[i] == think_open) return true;
+    }
+    return false;
+}
+
 // MARK: - Batch Processing
 
 int32_t llama_wrapper_decode_batch(struct llama_context *ctx,
@@ -236,33 +665,104 @@ llama_token llama_wrapper_sample_token(struct llama_context *ctx,
                                         struct llama_sampler_config config) {
     if (!ctx || !vocab) return -1;
     
-    struct llama_sampler *smpl = create_sampler(vocab, config);
+    struct wrapper_sampler *smpl = create_sampler(vocab, config, NULL, NULL, NULL, 0);
     if (!smpl) return -1;
     
-    llama_token token = llama_sampler_sample(smpl, ctx, -1);
-    llama_sampler_free(smpl);
+    llama_token token = sampler_sample(smpl, ctx, -1);
+    free_sampler(smpl);
     
     return token;
 }
 
 // MARK: - Generation
 
-int32_t llama_wrapper_generate(struct llama_context *ctx,
-                                struct llama_vocab *vocab,
-                                const char *prompt,
-                                int32_t max_tokens,
-                                struct llama_sampler_config config,
-                                llama_wrapper_token_callback token_callback,
-                                void *user_data,
-                                char *output_buffer,
-                                size_t output_buffer_size) {
-    if (!ctx || !vocab || !prompt || max_tokens <= 0) return -1;
+/// Per-sequence generation state, shared by single and batched generation
+struct generation_state {
+    struct llama_vocab *vocab;
+    struct wrapper_sampler *smpl;
+    struct wrapper_sampler *reason_smpl;  // Grammar-free sampler for the think block (may be smpl)
+    struct section_tracker tracker;
+    llama_token newline_token;          // Closes a section that has run over its budget
+    llama_token think_open;
+    llama_token think_close;
+    enum llama_reasoning_mode reasoning;
+    int32_t reasoning_budget;           // Think block is closed after this many tokens (-1 = unlimited)
+    bool in_reasoning;
+    
+    int32_t max_tokens;
+    int32_t n_generated;                // Answer tokens
+    int32_t n_reasoning;                // Tokens inside the think block
+    
+    llama_wrapper_token_callback token_callback;
+    void *user_data;
+    char *output_buffer;
+    size_t output_buffer_size;
+    size_t output_pos;
+    
+    // Buffer for incomplete UTF-8 sequences
+    char incomplete_buf[8];
+    int32_t incomplete_len;
+};
+
+/// Tokenize the prompt (plus any think-block prefill) and create the samplers
+/// @param prompt_tokens_out Set to the malloc'd prompt tokens on success
+/// @return Number of prompt tokens (negative on error)
+static int32_t generation_state_init(struct generation_state *state,
+                                     struct llama_vocab *vocab,
+                                     const char *prompt,
+                                     int32_t max_tokens,
+                                     struct llama_sampler_config config,
+                                     const struct llama_generation_options *options,
+                                     llama_wrapper_token_callback token_callback,
+                                     void *user_data,
+                                     char *output_buffer,
+                                     size_t output_buffer_size,
+                                     llama_token **prompt_tokens_out) {
+    memset(state, 0, sizeof(*state));
+    state->vocab = vocab;
+    state->max_tokens = max_tokens;
+    state->newline_token = -1;
+    state->token_callback = token_callback;
+    state->user_data = user_data;
+    state->output_buffer = output_buffer;
+    state->output_buffer_size = output_buffer_size;
+    if (output_buffer && output_buffer_size > 0) {
+        output_buffer[0] = '\0';
+    }
+    
+    // Resolve the grammar, compiling one from the section schema if needed
+    const char *grammar = options ? options->grammar : NULL;
+    char *section_grammar = NULL;
+    
+    if (options && options->sections && options->n_sections > 0) {
+        state->tracker.sections = options->sections;
+        state->tracker.n_sections = options->n_sections;
+        
+        if (!grammar) {
+            int32_t needed = -llama_wrapper_build_section_grammar(options->sections, options->n_sections, NULL, 0);
+            section_grammar = (char *)malloc(needed);
+            if (!section_grammar) return -1;
+            llama_wrapper_build_section_grammar(options->sections, options->n_sections, section_grammar, needed);
+            grammar = section_grammar;
+        }
+    }
+    
+    // Newline token used to close a section that has run over its budget
+    if (state->tracker.n_sections > 0) {
+        llama_token nl[4];
+        if (llama_tokenize(vocab, "\n", 1, nl, 4, false, false) == 1) {
+            state->newline_token = nl[0];
+        }
+    }
     
     // Tokenize the prompt
     int32_t prompt_len = (int32_t)strlen(prompt);
     int32_t n_tokens_estimate = prompt_len + 4;  // Rough estimate
     llama_token *prompt_tokens = (llama_token *)malloc(n_tokens_estimate * sizeof(llama_token));
-    if (!prompt_tokens) return -1;
+    if (!prompt_tokens) {
+        free(section_grammar);
+        return -1;
+    }
     
     int32_t n_prompt_tokens = llama_tokenize(vocab, prompt, prompt_len, prompt_tokens, n_tokens_estimate, true, false);
     
@@ -270,21 +770,270 @@ int32_t llama_wrapper_generate(struct llama_context *ctx,
     if (n_prompt_tokens < 0) {
         n_tokens_estimate = -n_prompt_tokens;
         prompt_tokens = (llama_token *)realloc(prompt_tokens, n_tokens_estimate * sizeof(llama_token));
-        if (!prompt_tokens) return -1;
+        if (!prompt_tokens) {
+            free(section_grammar);
+            return -1;
+        }
         n_prompt_tokens = llama_tokenize(vocab, prompt, prompt_len, prompt_tokens, n_tokens_estimate, true, false);
     }
     
     if (n_prompt_tokens < 0) {
+        free(prompt_tokens);
+        free(section_grammar);
+        return -1;
+    }
+    
+    // Reasoning control only applies to models with <think> tokens
+    state->reasoning = options ? options->reasoning : LLAMA_REASONING_KEEP;
+    state->reasoning_budget = options && options->reasoning == LLAMA_REASONING_BUDGET ? options->reasoning_budget : -1;
+    state->think_open = lookup_special_token(vocab, "<think>");
+    state->think_close = lookup_special_token(vocab, "</think>");
+    if (state->think_open < 0 || state->think_close < 0) {
+        state->reasoning = LLAMA_REASONING_KEEP;
+        state->reasoning_budget = -1;
+    }
+    
+    // Prefill the think block: closed when suppressing, open when budgeting or stripping
+    bool opens_think = state->think_open >= 0 &&
+                       prompt_opens_think(prompt_tokens, n_prompt_tokens, state->think_open, state->think_close);
+    const char *think_prefill = NULL;
+    if (state->reasoning == LLAMA_REASONING_SUPPRESS) {
+        think_prefill = opens_think ? "\n\n</think>\n\n" : "<think>\n\n</think>\n\n";
+    } else if (state->reasoning != LLAMA_REASONING_KEEP && !opens_think) {
+        think_prefill = "<think>\n";
+    }
+    
+    if (think_prefill) {
+        n_prompt_tokens = append_special_tokens(vocab, think_prefill, &prompt_tokens, n_prompt_tokens);
+        if (n_prompt_tokens < 0) {
+            free(prompt_tokens);
+            free(section_grammar);
+            return -1;
+        }
+    }
+    state->in_reasoning = state->reasoning != LLAMA_REASONING_KEEP && state->reasoning != LLAMA_REASONING_SUPPRESS;
+    
+    // Create sampler, banning a second think block once one has been prefilled
+    llama_logit_bias ban_think = { state->think_open, -INFINITY };
+    bool ban = state->reasoning != LLAMA_REASONING_KEEP;
+    state->smpl = create_sampler(vocab, config, grammar, options ? options->grammar_root : NULL,
+                                 ban ? &ban_think : NULL, ban ? 1 : 0);
+    
+    // The grammar only applies to the answer, so reasoning needs its own sampler
+    state->reason_smpl = state->smpl;
+    if (state->smpl && state->in_reasoning && grammar) {
+        state->reason_smpl = create_sampler(vocab, config, NULL, NULL, &ban_think, 1);
+        if (!state->reason_smpl) {
+            free_sampler(state->smpl);
+            state->smpl = NULL;
+        }
+    }
+    free(section_grammar);
+    
+    if (!state->smpl) {
         free(prompt_tokens);
         return -1;
     }
     
-    // Check context size
+    *prompt_tokens_out = prompt_tokens;
+    return n_prompt_tokens;
+}
+
+/// Append a piece to the output, holding back incomplete UTF-8 sequences
+static void generation_state_emit(struct generation_state *state, char *piece_buf, int32_t piece_len) {
+    char *output_buffer = state->output_buffer;
+    
+    if (state->incomplete_len > 0) {
+        memcpy(state->incomplete_buf + state->incomplete_len, piece_buf, piece_len < (size_t)(8 - state->incomplete_len) ? piece_len : (8 - state->incomplete_len));
+        state->incomplete_len += piece_len;
+        
+        // Try to decode
+        if (state->incomplete_len >= 0) {
+            // Simple check: if first byte indicates multi-byte sequence
+            unsigned char first = (unsigned char)state->incomplete_buf[0];
+            int expected = 1;
+            if ((first & 0xE0) == 0xC0) expected = 2;
+            else if ((first & 0xF0) == 0xE0) expected = 3;
+            else if ((first & 0xF8) == 0xF0) expected = 4;
+            
+            if (state->incomplete_len >= expected) {
+                // We have a complete character
+                if (state->token_callback) {
+                    state->incomplete_buf[state->incomplete_len] = '\0';
+                    state->token_callback(state->incomplete_buf, state->user_data);
+                }
+                
+                // Add to output buffer
+                if (output_buffer && state->output_pos + state->incomplete_len < state->output_buffer_size) {
+                    memcpy(output_buffer + state->output_pos, state->incomplete_buf, state->incomplete_len);
+                    state->output_pos += state->incomplete_len;
+                    output_buffer[state->output_pos] = '\0';
+                }
+                
+                state->incomplete_len = 0;
+            }
+        }
+    } else {
+        // Check if this starts a multi-byte UTF-8 sequence
+        unsigned char first = (unsigned char)piece_buf[0];
+        bool is_multibyte = ((first & 0xE0) == 0xC0) ||  // 2-byte
+                           ((first & 0xF0) == 0xE0) ||  // 3-byte
+                           ((first & 0xF8) == 0xF0);    // 4-byte
+        
+        if (is_multibyte && piece_len == 1) {
+            // Start of multi-byte sequence but incomplete
+            state->incomplete_buf[0] = piece_buf[0];
+            state->incomplete_len = 1;
+        } else {
+            // Complete token
+            piece_buf[piece_len] = '\0';
+            
+            if (state->token_callback) {
+                state->token_callback(piece_buf, state->user_data);
+            }
+            
+            if (output_buffer && state->output_pos + piece_len < state->output_buffer_size) {
+                memcpy(output_buffer + state->output_pos, piece_buf, piece_len);
+                state->output_pos += piece_len;
+                output_buffer[state->output_pos] = '\0';
+            }
+        }
+    }
+}
+
+/// Choose the next token from the logits at idx and emit it
+/// @param idx Batch index of the logits to sample (-1 for the last)
+/// @param token_out Set to the token to decode next
+/// @return false once the sequence is finished (token_out is not decoded)
+static bool generation_state_step(struct generation_state *state,
+                                  struct llama_context *ctx,
+                                  int32_t idx,
+                                  llama_token *token_out) {
+    // In KEEP mode reasoning is part of the output and counts towards max_tokens
+    int32_t n_counted = state->n_generated + (state->reasoning == LLAMA_REASONING_KEEP ? state->n_reasoning : 0);
+    if (n_counted >= state->max_tokens) return false;
+    
+    struct section_tracker *tracker = &state->tracker;
+    struct wrapper_sampler *active = state->in_reasoning ? state->reason_smpl : state->smpl;
+    llama_token new_token = -1;
+    bool forced = false;
+    
+    if (state->in_reasoning && state->reasoning_budget >= 0 &&
+        state->n_reasoning >= state->reasoning_budget) {
+        // Reasoning budget exhausted - close the think block
+        new_token = state->think_close;
+        forced = true;
+    } else if (!state->in_reasoning && tracker->n_sections > 0 && section_tracker_over_budget(tracker)) {
+        // The final section has used its budget - stop here
+        if (tracker->current == tracker->n_sections - 1) {
+            return false;
+        }
+        // Otherwise force newlines until the section closes
+        if (state->newline_token >= 0) {
+            new_token = state->newline_token;
+            forced = true;
+        } else {
+            tracker->sections = NULL;
+            tracker->n_sections = 0;
+        }
+    }
+    
+    if (forced) {
+        sampler_accept(active, new_token);
+    } else {
+        // Sample next token (accepted by the sampler)
+        new_token = sampler_sample(active, ctx, idx);
+    }
+    
+    // Check for end of generation
+    if (llama_vocab_is_eog(state->vocab, new_token)) {
+        return false;
+    }
+    
+    // Track the think block
+    bool is_reasoning = state->in_reasoning || (state->think_open >= 0 && new_token == state->think_open);
+    if (is_reasoning) {
+        state->n_reasoning++;
+        state->in_reasoning = new_token != state->think_close;
+    }
+    
+    // Convert token to piece
+    char piece_buf[32];
+    int32_t piece_len = llama_token_to_piece(state->vocab, new_token, piece_buf, sizeof(piece_buf), 0, false);
+    
+    if (!is_reasoning && tracker->n_sections > 0) {
+        tracker->n_tokens++;
+        if (piece_len > 0) {
+            section_tracker_observe(tracker, piece_buf, piece_len);
+        }
+    }
+    
+    // Reasoning only reaches the output in KEEP mode
+    bool emit = !is_reasoning || state->reasoning == LLAMA_REASONING_KEEP;
+    if (piece_len > 0 && emit) {
+        generation_state_emit(state, piece_buf, piece_len);
+    }
+    
+    if (!is_reasoning) {
+        state->n_generated++;
+    }
+    
+    // Stop as soon as the final section is closed
+    if (tracker->closed) {
+        return false;
+    }
+    
+    *token_out = new_token;
+    return true;
+}
+
+/// Flush any held-back UTF-8 and free the samplers
+static void generation_state_free(struct generation_state *state) {
+    if (state->incomplete_len > 0 && state->output_buffer &&
+        state->output_pos + state->incomplete_len < state->output_buffer_size) {
+        memcpy(state->output_buffer + state->output_pos, state->incomplete_buf, state->incomplete_len);
+        state->output_buffer[state->output_pos + state->incomplete_len] = '\0';
+    }
+    state->incomplete_len = 0;
+    
+    if (state->reason_smpl != state->smpl) {
+        free_sampler(state->reason_smpl);
+    }
+    free_sampler(state->smpl);
+    state->smpl = NULL;
+    state->reason_smpl = NULL;
+}
+
+int32_t llama_wrapper_generate(struct llama_context *ctx,
+                                struct llama_vocab *vocab,
+                                const char *prompt,
+                                int32_t max_tokens,
+                                struct llama_sampler_config config,
+                                const struct llama_generation_options *options,
+                                llama_wrapper_token_callback token_callback,
+                                void *user_data,
+                                char *output_buffer,
+                                size_t output_buffer_size,
+                                struct llama_generation_stats *stats) {
+    if (!ctx || !vocab || !prompt || max_tokens <= 0) return -1;
+    
+    int64_t t_start_us = llama_time_us();
+    
+    struct generation_state state;
+    llama_token *prompt_tokens = NULL;
+    int32_t n_prompt_tokens = generation_state_init(&state, vocab, prompt, max_tokens, config, options,
+                                                    token_callback, user_data,
+                                                    output_buffer, output_buffer_size, &prompt_tokens);
+    if (n_prompt_tokens < 0) return -1;
+    
+    // Check context size, leaving room for a budgeted think block (as batch_slot_assign does)
     uint32_t n_ctx = llama_n_ctx(ctx);
-    if ((uint32_t)n_prompt_tokens + max_tokens > n_ctx) {
-        max_tokens = (int32_t)n_ctx - n_prompt_tokens;
-        if (max_tokens <= 0) {
+    int64_t n_reasoning = state.reasoning_budget >= 0 ? state.reasoning_budget + 1 : 0;
+    if ((int64_t)n_prompt_tokens + max_tokens + n_reasoning > (int64_t)n_ctx) {
+        state.max_tokens = (int32_t)((int64_t)n_ctx - n_prompt_tokens - n_reasoning);
+        if (state.max_tokens <= 0) {
             free(prompt_tokens);
+            generation_state_free(&state);
             return -1;
         }
     }
@@ -299,6 +1048,7 @@ int32_t llama_wrapper_generate(struct llama_context *ctx,
         struct llama_batch batch = llama_batch_init(batch_size, 0, 1);
         if (!batch.token) {
             free(prompt_tokens);
+            generation_state_free(&state);
             return -1;
         }
         
@@ -319,6 +1069,7 @@ int32_t llama_wrapper_generate(struct llama_context *ctx,
         
         if (result != 0) {
             free(prompt_tokens);
+            generation_state_free(&state);
             return -1;
         }
         
@@ -328,120 +1079,320 @@ int32_t llama_wrapper_generate(struct llama_context *ctx,
     
     free(prompt_tokens);
     
-    // Create sampler
-    struct llama_sampler *smpl = create_sampler(vocab, config);
-    if (!smpl) return -1;
+    int64_t t_prompt_us = llama_time_us();
     
     // Generation loop
-    int32_t n_generated = 0;
-    size_t output_pos = 0;
-    llama_token prev_token = -1;
+    int32_t n_past = n_prompt_tokens;
+    llama_token new_token;
     
-    // Buffer for incomplete UTF-8 sequences
-    char incomplete_buf[8] = {0};
-    int32_t incomplete_len = 0;
-    
-    while (n_generated < max_tokens) {
-        // Sample next token
-        llama_token new_token = llama_sampler_sample(smpl, ctx, -1);
-        
-        // Accept the token for repetition penalty
-        llama_sampler_accept(smpl, new_token);
-        
-        // Check for end of generation
-        if (llama_vocab_is_eog(vocab, new_token)) {
+    while (n_past < (int32_t)n_ctx && generation_state_step(&state, ctx, -1, &new_token)) {
+        // Prepare next batch with single token
+        struct llama_batch batch = llama_batch_get_one(&new_token, 1);
+        if (llama_decode(ctx, batch) != 0) {
             break;
         }
-        
-        // Convert token to piece
-        char piece_buf[32];
-        int32_t piece_len = llama_token_to_piece(vocab, new_token, piece_buf, sizeof(piece_buf), 0, false);
-        
-        if (piece_len > 0) {
-            // Handle incomplete UTF-8
-            if (incomplete_len > 0) {
-                memcpy(incomplete_buf + incomplete_len, piece_buf, piece_len < (size_t)(8 - incomplete_len) ? piece_len : (8 - incomplete_len));
-                incomplete_len += piece_len;
-                
-                // Try to decode
-                if (incomplete_len >= 0) {
-                    // Simple check: if first byte indicates multi-byte sequence
-                    unsigned char first = (unsigned char)incomplete_buf[0];
-                    int expected = 1;
-                    if ((first & 0xE0) == 0xC0) expected = 2;
-                    else if ((first & 0xF0) == 0xE0) expected = 3;
-                    else if ((first & 0xF8) == 0xF0) expected = 4;
-                    
-                    if (incomplete_len >= expected) {
-                        // We have a complete character
-                        if (token_callback) {
-                            incomplete_buf[incomplete_len] = '\0';
-                            token_callback(incomplete_buf, user_data);
-                        }
-                        
-                        // Add to output buffer
-                        if (output_buffer && output_pos + incomplete_len < output_buffer_size) {
-                            memcpy(output_buffer + output_pos, incomplete_buf, incomplete_len);
-                            output_pos += incomplete_len;
-                            output_buffer[output_pos] = '\0';
-                        }
-                        
-                        incomplete_len = 0;
-                    }
-                }
-            } else {
-                // Check if this starts a multi-byte UTF-8 sequence
-                unsigned char first = (unsigned char)piece_buf[0];
-                bool is_multibyte = ((first & 0xE0) == 0xC0) ||  // 2-byte
-                                   ((first & 0xF0) == 0xE0) ||  // 3-byte
-                                   ((first & 0xF8) == 0xF0);    // 4-byte
+        n_past++;
+    }
+    
+    generation_state_free(&state);
+    
+    if (stats) {
+        int64_t t_end_us = llama_time_us();
+        stats->n_prompt_tokens = n_prompt_tokens;
+        stats->n_generated_tokens = state.n_generated + state.n_reasoning;
+        stats->n_reasoning_tokens = state.n_reasoning;
+        stats->t_prompt_ms = (t_prompt_us - t_start_us) / 1000.0;
+        stats->t_generate_ms = (t_end_us - t_prompt_us) / 1000.0;
+    }
+    
+    return state.n_generated + state.n_reasoning;
+}
+
+void llama_wrapper_clear_kv_cache(struct llama_context *ctx) {
+    if (ctx) {
+        llama_memory_clear(llama_get_memory(ctx), true);
+    }
+}
+
+// MARK: - Batch Jobs
+
+/// A job running in one sequence of the batch context
+struct batch_slot {
+    int32_t job;                // Index of the job (-1 if free)
+    bool started;               // KV cells reserved and prompt submitted
+    struct generation_state state;
+    llama_token *prompt_tokens;
+    int32_t n_prompt_tokens;
+    int32_t n_prompt_done;      // Prompt tokens submitted so far
+    int32_t n_past;             // Tokens in the sequence's KV cache
+    int32_t n_reserved;         // KV cells reserved for the job
+    llama_token pending;        // Sampled token waiting to be decoded (-1 if none)
+    int32_t i_batch;            // Index of the slot's logits in the current batch (-1 if none)
+    int64_t t_start_us;
+    int64_t t_prompt_us;
+};
+
+static void batch_add(struct llama_batch *batch, llama_token token, int32_t pos, int32_t seq_id, bool logits) {
+    int32_t i = batch->n_tokens++;
+    batch->token[i] = token;
+    batch->pos[i] = pos;
+    batch->n_seq_id[i] = 1;
+    batch->seq_id[i][0] = seq_id;
+    batch->logits[i] = logits ? 1 : 0;
+}
+
+/// Tokenize a job into a free slot and size its KV reservation
+/// @return false if the job cannot run (empty or too long for the context)
+static bool batch_slot_assign(struct batch_slot *slot,
+                              int32_t job_index,
+                              struct llama_batch_job *job,
+                              struct llama_vocab *vocab,
+                              struct llama_sampler_config config,
+                              int32_t n_ctx) {
+    if (!job->prompt || job->max_tokens <= 0) return false;
+    
+    int32_t n_prompt_tokens = generation_state_init(&slot->state, vocab, job->prompt, job->max_tokens, config,
+                                                    job->options, NULL, NULL,
+                                                    job->output_buffer, job->output_buffer_size,
+                                                    &slot->prompt_tokens);
+    if (n_prompt_tokens < 0) return false;
+    
+    if (n_prompt_tokens >= n_ctx) {
+        free(slot->prompt_tokens);
+        generation_state_free(&slot->state);
+        return false;
+    }
+    
+    // Each slot reserves a fixed share of the KV cache, so free reasoning has to be bounded:
+    // STRIP closes the think block after max_tokens (KEEP counts it against max_tokens already)
+    if (slot->state.reasoning == LLAMA_REASONING_STRIP) {
+        slot->state.reasoning_budget = job->max_tokens;
+    }
+    
+    // Reserve room for the answer and the think block, capped like llama_wrapper_generate
+    int64_t n_reasoning = slot->state.reasoning_budget >= 0 ? slot->state.reasoning_budget + 1 : 0;
+    int64_t n_needed = (int64_t)n_prompt_tokens + job->max_tokens + n_reasoning;
+    
+    slot->job = job_index;
+    slot->started = false;
+    slot->n_prompt_tokens = n_prompt_tokens;
+    slot->n_prompt_done = 0;
+    slot->n_past = 0;
+    slot->n_reserved = n_needed < n_ctx ? (int32_t)n_needed : n_ctx;
+    slot->pending = -1;
+    slot->i_batch = -1;
+    slot->t_start_us = 0;
+    slot->t_prompt_us = 0;
+    return true;
+}
+
+static void batch_slot_release(struct batch_slot *slot) {
+    generation_state_free(&slot->state);
+    free(slot->prompt_tokens);
+    slot->prompt_tokens = NULL;
+    slot->job = -1;
+    slot->started = false;
+}
+
+struct llama_context *llama_wrapper_new_batch_context(struct llama_model *model,
+                                                       uint32_t n_ctx,
+                                                       uint32_t n_seq_max,
+                                                       int32_t n_threads,
+                                                       int32_t n_threads_batch) {
+    if (!model) return NULL;
+    
+    uint32_t n_seq = n_seq_max > 0 ? n_seq_max : 1;
+    
+    struct llama_context_params params = llama_context_default_params();
+    params.n_ctx = n_ctx > 0 ? n_ctx : WRAPPER_DEFAULT_N_CTX * n_seq;
+    params.n_batch = WRAPPER_N_UBATCH;
+    params.n_ubatch = WRAPPER_N_UBATCH;
+    params.n_seq_max = n_seq;
+    params.kv_unified = true;  // One pool of cells shared by all sequences
+    params.n_threads = n_threads > 0 ? n_threads : 2;
+    params.n_threads_batch = n_threads_batch > 0 ? n_threads_batch : params.n_threads;
+    params.offload_kqv = false;
+    
+    return llama_init_from_model(model, params);
+}
+
+int32_t llama_wrapper_run_batch_jobs(struct llama_context *ctx,
+                                     struct llama_vocab *vocab,
+                                     struct llama_batch_job *jobs,
+                                     int32_t n_jobs,
+                                     struct llama_sampler_config config,
+                                     llama_wrapper_batch_job_callback job_callback,
+                                     void *user_data,
+                                     struct llama_batch_run_stats *stats) {
+    if (!ctx || !vocab || !jobs || n_jobs <= 0) return -1;
+    
+    int32_t n_slots = (int32_t)llama_n_seq_max(ctx);
+    int32_t n_ctx = (int32_t)llama_n_ctx(ctx);
+    int32_t n_batch = (int32_t)llama_n_batch(ctx);
+    llama_memory_t mem = llama_get_memory(ctx);
+    
+    struct batch_slot *slots = (struct batch_slot *)calloc(n_slots, sizeof(*slots));
+    if (!slots) return -1;
+    
+    struct llama_batch batch = llama_batch_init(n_batch, 0, 1);
+    if (!batch.token) {
+        free(slots);
+        return -1;
+    }
+    
+    for (int32_t s = 0; s < n_slots; s++) {
+        slots[s].job = -1;
+    }
+    for (int32_t j = 0; j < n_jobs; j++) {
+        jobs[j].status = LLAMA_BATCH_JOB_PENDING;
+        memset(&jobs[j].stats, 0, sizeof(jobs[j].stats));
+        jobs[j].t_wait_ms = 0;
+        jobs[j].t_latency_ms = 0;
+    }
+    
+    llama_memory_clear(mem, true);
+    
+    struct llama_batch_run_stats run = {0};
+    int64_t t_run_us = llama_time_us();
+    int32_t next_job = 0;
+    int32_t n_reserved = 0;
+    bool failed = false;
+    bool cancelled = false;
+    
+    while (!cancelled) {
+        // Hand queued jobs to free sequences in order
+        for (int32_t s = 0; s < n_slots && next_job < n_jobs; s++) {
+            while (slots[s].job < 0 && next_job < n_jobs) {
+                int32_t j = next_job++;
+                if (batch_slot_assign(&slots[s], j, &jobs[j], vocab, config, n_ctx)) break;
                 
-                if (is_multibyte && piece_len == 1) {
-                    // Start of multi-byte sequence but incomplete
-                    incomplete_buf[0] = piece_buf[0];
-                    incomplete_len = 1;
-                } else {
-                    // Complete token
-                    piece_buf[piece_len] = '\0';
-                    
-                    if (token_callback) {
-                        token_callback(piece_buf, user_data);
-                    }
-                    
-                    if (output_buffer && output_pos + piece_len < output_buffer_size) {
-                        memcpy(output_buffer + output_pos, piece_buf, piece_len);
-                        output_pos += piece_len;
-                        output_buffer[output_pos] = '\0';
-                    }
+                jobs[j].status = LLAMA_BATCH_JOB_FAILED;
+                jobs[j].t_latency_ms = (llama_time_us() - t_run_us) / 1000.0;
+                run.n_jobs_failed++;
+                if (job_callback && !job_callback(j, &jobs[j], user_data)) {
+                    cancelled = true;
+                    break;
                 }
             }
         }
+        if (cancelled) break;
         
-        prev_token = new_token;
-        n_generated++;
+        // Start assigned jobs while their reservations fit in the KV cache
+        for (int32_t s = 0; s < n_slots; s++) {
+            struct batch_slot *slot = &slots[s];
+            if (slot->job < 0 || slot->started || n_reserved + slot->n_reserved > n_ctx) continue;
+            
+            slot->started = true;
+            slot->t_start_us = llama_time_us();
+            n_reserved += slot->n_reserved;
+            jobs[slot->job].t_wait_ms = (slot->t_start_us - t_run_us) / 1000.0;
+        }
+        
+        // One token for every generating sequence, then fill the rest with prompt chunks
+        batch.n_tokens = 0;
+        for (int32_t s = 0; s < n_slots; s++) {
+            struct batch_slot *slot = &slots[s];
+            if (!slot->started || slot->pending < 0) continue;
+            
+            slot->i_batch = batch.n_tokens;
+            batch_add(&batch, slot->pending, slot->n_past++, s, true);
+            slot->pending = -1;
+        }
+        for (int32_t s = 0; s < n_slots && batch.n_tokens < n_batch; s++) {
+            struct batch_slot *slot = &slots[s];
+            if (!slot->started || slot->n_prompt_done >= slot->n_prompt_tokens) continue;
+            
+            int32_t remaining = slot->n_prompt_tokens - slot->n_prompt_done;
+            int32_t space = n_batch - batch.n_tokens;
+            int32_t n = remaining < space ? remaining : space;
+            
+            for (int32_t i = 0; i < n; i++) {
+                bool last = slot->n_prompt_done + i == slot->n_prompt_tokens - 1;
+                if (last) slot->i_batch = batch.n_tokens;
+                batch_add(&batch, slot->prompt_tokens[slot->n_prompt_done + i], slot->n_past++, s, last);
+            }
+            slot->n_prompt_done += n;
+            run.n_prompt_tokens += n;
+        }
+        
+        // Nothing left to decode
+        if (batch.n_tokens == 0) break;
         
-        // Prepare next batch with single token
-        struct llama_batch batch = llama_batch_get_one(&new_token, 1);
         if (llama_decode(ctx, batch) != 0) {
+            failed = true;
             break;
         }
+        run.n_decode_calls++;
+        
+        // Sample the next token of every sequence that has logits in this batch
+        for (int32_t s = 0; s < n_slots && !cancelled; s++) {
+            struct batch_slot *slot = &slots[s];
+            if (slot->i_batch < 0) continue;
+            
+            int64_t t_now_us = llama_time_us();
+            if (slot->t_prompt_us == 0) {
+                slot->t_prompt_us = t_now_us;
+            }
+            
+            llama_token token;
+            bool more = slot->n_past < slot->n_reserved &&
+                        generation_state_step(&slot->state, ctx, slot->i_batch, &token);
+            slot->i_batch = -1;
+            
+            if (more) {
+                slot->pending = token;
+                continue;
+            }
+            
+            // Finished - report the job and free its sequence for the next one
+            struct llama_batch_job *job = &jobs[slot->job];
+            int32_t job_index = slot->job;
+            
+            job->status = LLAMA_BATCH_JOB_DONE;
+            job->stats.n_prompt_tokens = slot->n_prompt_tokens;
+            job->stats.n_generated_tokens = slot->state.n_generated + slot->state.n_reasoning;
+            job->stats.n_reasoning_tokens = slot->state.n_reasoning;
+            job->stats.t_prompt_ms = (slot->t_prompt_us - slot->t_start_us) / 1000.0;
+            job->stats.t_generate_ms = (t_now_us - slot->t_prompt_us) / 1000.0;
+            job->t_latency_ms = (t_now_us - t_run_us) / 1000.0;
+            
+            run.n_jobs_done++;
+            run.n_generated_tokens += job->stats.n_generated_tokens;
+            
+            llama_memory_seq_rm(mem, s, -1, -1);
+            n_reserved -= slot->n_reserved;
+            batch_slot_release(slot);
+            
+            if (job_callback && !job_callback(job_index, job, user_data)) {
+                cancelled = true;
+            }
+        }
     }
     
-    // Flush any remaining incomplete UTF-8
-    if (incomplete_len > 0 && output_buffer && output_pos + incomplete_len < output_buffer_size) {
-        memcpy(output_buffer + output_pos, incomplete_buf, incomplete_len);
-        output_buffer[output_pos + incomplete_len] = '\0';
+    // Jobs still in a slot were interrupted: failed on a decode error, left pending on cancel
+    for (int32_t s = 0; s < n_slots; s++) {
+        if (slots[s].job < 0) continue;
+        if (failed) {
+            jobs[slots[s].job].status = LLAMA_BATCH_JOB_FAILED;
+            run.n_jobs_failed++;
+        }
+        batch_slot_release(&slots[s]);
     }
     
-    llama_sampler_free(smpl);
+    llama_memory_clear(mem, true);
+    llama_batch_free(batch);
+    free(slots);
     
-    return n_generated;
-}
-
-void llama_wrapper_clear_kv_cache(struct llama_context *ctx) {
-    if (ctx) {
-        llama_memory_clear(llama_get_memory(ctx), true);
+    if (stats) {
+        run.t_total_ms = (llama_time_us() - t_run_us) / 1000.0;
+        if (run.t_total_ms > 0) {
+            run.prompt_tokens_per_s = run.n_prompt_tokens * 1000.0 / run.t_total_ms;
+            run.generated_tokens_per_s = run.n_generated_tokens * 1000.0 / run.t_total_ms;
+        }
+        *stats = run;
     }
+    
+    return failed ? -1 : run.n_jobs_done;
 }
 
 // MARK: - Utility
@@ -0,0 +1,324 @@
+//
+//  audio_spool.c
+//  HxDictate
+//
+//  Append-only PCM16 spool for encounter audio
+//
+
+#include "include/audio_spool.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define SPOOL_MAGIC "HXSP"
+#define SPOOL_VERSION 1
+
+/// On-disk header, stored at the start of the header page
+struct spool_header {
+    char magic[4];
+    uint32_t version;
+    uint32_t sample_rate;
+    uint32_t channels;
+    uint32_t block_samples;
+    uint32_t header_size;
+    int64_t committed_samples;
+};
+
+struct audio_spool_writer {
+    int fd;
+    int16_t *block;
+    int32_t block_samples;
+    int32_t block_fill;
+    int32_t sync_interval_blocks;
+    int32_t blocks_since_sync;
+    int64_t n_written;      // Samples written to the file
+    int64_t n_committed;    // Samples recorded in the header
+};
+
+struct audio_spool_reader {
+    void *map;
+    size_t map_size;
+    const int16_t *samples;
+    int64_t n_samples;
+};
+
+// MARK: - Conversion
+
+void audio_spool_pcm16_to_float(const int16_t *src, float *dst, size_t n) {
+    const float scale = 1.0f / 32768.0f;
+    size_t i = 0;
+
+#if defined(__ARM_NEON)
+    const float32x4_t vscale = vdupq_n_f32(scale);
+    for (; i + 8 <= n; i += 8) {
+        int16x8_t v = vld1q_s16(src + i);
+        float32x4_t lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(v)));
+        float32x4_t hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(v)));
+        vst1q_f32(dst + i, vmulq_f32(lo, vscale));
+        vst1q_f32(dst + i + 4, vmulq_f32(hi, vscale));
+    }
+#elif defined(__SSE2__)
+    const __m128 vscale = _mm_set1_ps(scale);
+    for (; i + 8 <= n; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+        // Sign-extend by unpacking into the high half and shifting back down
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), vscale));
+        _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), vscale));
+    }
+#endif
+
+    for (; i < n; i++) {
+        dst[i] = (float)src[i] * scale;
+    }
+}
+
+void audio_spool_float_to_pcm16(const float *src, int16_t *dst, size_t n) {
+    size_t i = 0;
+
+#if defined(__ARM_NEON)
+    const float32x4_t vmin = vdupq_n_f32(-1.0f);
+    const float32x4_t vmax = vdupq_n_f32(1.0f);
+    const float32x4_t vscale = vdupq_n_f32(32767.0f);
+    for (; i + 8 <= n; i += 8) {
+        float32x4_t lo = vminq_f32(vmaxq_f32(vld1q_f32(src + i), vmin), vmax);
+        float32x4_t hi = vminq_f32(vmaxq_f32(vld1q_f32(src + i + 4), vmin), vmax);
+        int32x4_t ilo = vcvtq_s32_f32(vmulq_f32(lo, vscale));
+        int32x4_t ihi = vcvtq_s32_f32(vmulq_f32(hi, vscale));
+        vst1q_s16(dst + i, vcombine_s16(vqmovn_s32(ilo), vqmovn_s32(ihi)));
+    }
+#elif defined(__SSE2__)
+    const __m128 vmin = _mm_set1_ps(-1.0f);
+    const __m128 vmax = _mm_set1_ps(1.0f);
+    const __m128 vscale = _mm_set1_ps(32767.0f);
+    for (; i + 8 <= n; i += 8) {
+        __m128 lo = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i), vmin), vmax);
+        __m128 hi = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i + 4), vmin), vmax);
+        __m128i ilo = _mm_cvttps_epi32(_mm_mul_ps(lo, vscale));
+        __m128i ihi = _mm_cvttps_epi32(_mm_mul_ps(hi, vscale));
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_packs_epi32(ilo, ihi));
+    }
+#endif
+
+    for (; i < n; i++) {
+        float v = src[i];
+        if (v > 1.0f) v = 1.0f;
+        if (v < -1.0f) v = -1.0f;
+        dst[i] = (int16_t)(v * 32767.0f);
+    }
+}
+
+// MARK: - Writer
+
+static int write_all(int fd, const void *buf, size_t len, off_t offset) {
+    const char *p = (const char *)buf;
+    while (len > 0) {
+        ssize_t n = pwrite(fd, p, len, offset);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += n;
+        len -= (size_t)n;
+        offset += n;
+    }
+    return 0;
+}
+
+static int write_header(int fd, int32_t block_samples, int64_t committed_samples) {
+    struct spool_header header = {0};
+    memcpy(header.magic, SPOOL_MAGIC, 4);
+    header.version = SPOOL_VERSION;
+    header.sample_rate = AUDIO_SPOOL_SAMPLE_RATE;
+    header.channels = 1;
+    header.block_samples = (uint32_t)block_samples;
+    header.header_size = AUDIO_SPOOL_HEADER_SIZE;
+    header.committed_samples = committed_samples;
+    return write_all(fd, &header, sizeof(header), 0);
+}
+
+/// Write the buffered block to the file
+static int write_block(struct audio_spool_writer *writer) {
+    if (writer->block_fill == 0) return 0;
+
+    off_t offset = AUDIO_SPOOL_HEADER_SIZE + (off_t)writer->n_written * (off_t)sizeof(int16_t);
+    if (write_all(writer->fd, writer->block, writer->block_fill * sizeof(int16_t), offset) != 0) {
+        return -1;
+    }
+    writer->n_written += writer->block_fill;
+    writer->block_fill = 0;
+    writer->blocks_since_sync++;
+    return 0;
+}
+
+/// Make written samples durable, then record them in the header and make that durable too
+static int commit(struct audio_spool_writer *writer) {
+    if (writer->n_committed == writer->n_written) return 0;
+
+    if (fsync(writer->fd) != 0) return -1;
+    if (write_header(writer->fd, writer->block_samples, writer->n_written) != 0) return -1;
+    if (fsync(writer->fd) != 0) return -1;
+
+    writer->n_committed = writer->n_written;
+    writer->blocks_since_sync = 0;
+    return 0;
+}
+
+struct audio_spool_writer *audio_spool_writer_open(const char *path,
+                                                   int32_t block_samples,
+                                                   int32_t sync_interval_blocks) {
+    if (!path) return NULL;
+
+    struct audio_spool_writer *writer = (struct audio_spool_writer *)calloc(1, sizeof(*writer));
+    if (!writer) return NULL;
+
+    writer->block_samples = block_samples > 0 ? block_samples : AUDIO_SPOOL_SAMPLE_RATE;
+    writer->sync_interval_blocks = sync_interval_blocks > 0 ? sync_interval_blocks : 5;
+    writer->block = (int16_t *)malloc(writer->block_samples * sizeof(int16_t));
+    writer->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+
+    if (!writer->block || writer->fd < 0) {
+        audio_spool_writer_close(writer);
+        return NULL;
+    }
+
+    // Reserve the full header page so samples start page-aligned
+    if (ftruncate(writer->fd, AUDIO_SPOOL_HEADER_SIZE) != 0 ||
+        write_header(writer->fd, writer->block_samples, 0) != 0) {
+        audio_spool_writer_close(writer);
+        return NULL;
+    }
+
+    return writer;
+}
+
+int audio_spool_writer_append(struct audio_spool_writer *writer, const float *samples, int32_t n_samples) {
+    if (!writer || writer->fd < 0 || !samples || n_samples < 0) return -1;
+
+    int32_t pos = 0;
+    while (pos < n_samples) {
+        int32_t space = writer->block_samples - writer->block_fill;
+        int32_t n = n_samples - pos < space ? n_samples - pos : space;
+
+        audio_spool_float_to_pcm16(samples + pos, writer->block + writer->block_fill, (size_t)n);
+        writer->block_fill += n;
+        pos += n;
+
+        if (writer->block_fill == writer->block_samples) {
+            if (write_block(writer) != 0) return -1;
+            if (writer->blocks_since_sync >= writer->sync_interval_blocks && commit(writer) != 0) {
+                return -1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+int audio_spool_writer_flush(struct audio_spool_writer *writer) {
+    if (!writer || writer->fd < 0) return -1;
+    if (write_block(writer) != 0) return -1;
+    return commit(writer);
+}
+
+int64_t audio_spool_writer_n_samples(const struct audio_spool_writer *writer) {
+    if (!writer) return 0;
+    return writer->n_written + writer->block_fill;
+}
+
+void audio_spool_writer_close(struct audio_spool_writer *writer) {
+    if (!writer) return;
+
+    if (writer->fd >= 0) {
+        audio_spool_writer_flush(writer);
+        fsync(writer->fd);
+        close(writer->fd);
+    }
+    free(writer->block);
+    free(writer);
+}
+
+// MARK: - Reader
+
+struct audio_spool_reader *audio_spool_reader_open(const char *path) {
+    if (!path) return NULL;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+
+    struct stat st;
+    struct spool_header header;
+    if (fstat(fd, &st) != 0 || st.st_size < AUDIO_SPOOL_HEADER_SIZE ||
+        pread(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header) ||
+        memcmp(header.magic, SPOOL_MAGIC, 4) != 0 ||
+        header.version != SPOOL_VERSION ||
+        header.header_size != AUDIO_SPOOL_HEADER_SIZE) {
+        close(fd);
+        return NULL;
+    }
+
+    void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return NULL;
+
+    madvise(map, (size_t)st.st_size, MADV_SEQUENTIAL);
+
+    struct audio_spool_reader *reader = (struct audio_spool_reader *)calloc(1, sizeof(*reader));
+    if (!reader) {
+        munmap(map, (size_t)st.st_size);
+        return NULL;
+    }
+
+    // Only replay samples that were committed and are actually on disk
+    int64_t on_disk = (st.st_size - AUDIO_SPOOL_HEADER_SIZE) / (int64_t)sizeof(int16_t);
+    reader->map = map;
+    reader->map_size = (size_t)st.st_size;
+    reader->samples = (const int16_t *)((const char *)map + AUDIO_SPOOL_HEADER_SIZE);
+    reader->n_samples = header.committed_samples < on_disk ? header.committed_samples : on_disk;
+
+    return reader;
+}
+
+int64_t audio_spool_reader_n_samples(const struct audio_spool_reader *reader) {
+    if (!reader) return 0;
+    return reader->n_samples;
+}
+
+const int16_t *audio_spool_reader_samples(const struct audio_spool_reader *reader) {
+    if (!reader) return NULL;
+    return reader->samples;
+}
+
+int32_t audio_spool_reader_read(const struct audio_spool_reader *reader,
+                                int64_t offset,
+                                int32_t n_samples,
+                                float *out) {
+    if (!reader || !out || offset < 0 || n_samples < 0) return -1;
+    if (offset >= reader->n_samples) return 0;
+
+    int64_t available = reader->n_samples - offset;
+    int32_t n = available < n_samples ? (int32_t)available : n_samples;
+    audio_spool_pcm16_to_float(reader->samples + offset, out, (size_t)n);
+    return n;
+}
+
+void audio_spool_reader_close(struct audio_spool_reader *reader) {
+    if (!reader) return;
+
+    if (reader->map) {
+        munmap(reader->map, reader->map_size);
+    }
+    free(reader);
+}
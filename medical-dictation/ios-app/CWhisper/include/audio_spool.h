@@ -0,0 +1,88 @@
+//
+//  audio_spool.h
+//  HxDictate
+//
+//  Append-only PCM16 spool for encounter audio
+//
+//  File layout:
+//    [4096-byte header page][int16 samples ...]
+//  Samples are 16 kHz mono PCM16, written in fixed-size blocks. The header
+//  records the number of committed (fsync'd) samples, so a spool that was
+//  interrupted by a crash can be replayed up to its last commit.
+//
+
+#ifndef audio_spool_h
+#define audio_spool_h
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define AUDIO_SPOOL_SAMPLE_RATE 16000
+#define AUDIO_SPOOL_HEADER_SIZE 4096
+
+// Opaque types
+struct audio_spool_writer;
+struct audio_spool_reader;
+
+// MARK: - Writer
+
+/// Create a new spool file (truncates an existing file)
+/// @param path Path of the spool file
+/// @param block_samples Samples per write block (0 for 1 second)
+/// @param sync_interval_blocks Blocks written between fsyncs (0 for 5)
+/// @return Pointer to writer or NULL on error
+struct audio_spool_writer *audio_spool_writer_open(const char *path,
+                                                   int32_t block_samples,
+                                                   int32_t sync_interval_blocks);
+
+/// Append float samples in [-1, 1] (converted to PCM16)
+/// @return 0 on success, non-zero on error
+int audio_spool_writer_append(struct audio_spool_writer *writer, const float *samples, int32_t n_samples);
+
+/// Write any buffered samples, fsync and commit them to the header
+/// @return 0 on success, non-zero on error
+int audio_spool_writer_flush(struct audio_spool_writer *writer);
+
+/// Number of samples appended so far (committed or not)
+int64_t audio_spool_writer_n_samples(const struct audio_spool_writer *writer);
+
+/// Flush and close the spool
+void audio_spool_writer_close(struct audio_spool_writer *writer);
+
+// MARK: - Reader
+
+/// Map a spool file for reading
+/// @param path Path of the spool file
+/// @return Pointer to reader or NULL on error
+struct audio_spool_reader *audio_spool_reader_open(const char *path);
+
+/// Number of committed samples in the spool
+int64_t audio_spool_reader_n_samples(const struct audio_spool_reader *reader);
+
+/// Zero-copy pointer to the mapped PCM16 samples
+const int16_t *audio_spool_reader_samples(const struct audio_spool_reader *reader);
+
+/// Convert a window of samples to float
+/// @param reader The reader
+/// @param offset First sample of the window
+/// @param n_samples Maximum number of samples to convert
+/// @param out Output buffer (at least n_samples floats)
+/// @return Number of samples converted (negative on error)
+int32_t audio_spool_reader_read(const struct audio_spool_reader *reader,
+                                int64_t offset,
+                                int32_t n_samples,
+                                float *out);
+
+/// Unmap and close the spool
+void audio_spool_reader_close(struct audio_spool_reader *reader);
+
+// MARK: - Conversion
+
+/// Convert PCM16 samples to float in [-1, 1]
+void audio_spool_pcm16_to_float(const int16_t *src, float *dst, size_t n);
+
+/// Convert float samples to PCM16 (clamped)
+void audio_spool_float_to_pcm16(const float *src, int16_t *dst, size_t n);
+
+#endif /* audio_spool_h */
@@ -15,11 +15,47 @@
 struct whisper_context;
 struct whisper_context_params;
 struct whisper_full_params;
+struct audio_spool_reader;
 
 // Note: whisper_sampling_strategy enum is defined in whisper.h
 // We just need to declare it here for the function signatures
 enum whisper_sampling_strategy;
 
+// Model Inspection
+// Header-only read of a ggml whisper model (hyperparameters, vocab and tensor infos)
+struct whisper_model_info {
+    char model_type[24];      // e.g. "small", "large-v3", "large-v3-turbo"
+    char dominant_type[16];   // Tensor type holding the most bytes (e.g. "f16", "q5_0")
+    int32_t n_vocab;
+    int32_t n_audio_ctx;
+    int32_t n_audio_state;
+    int32_t n_audio_head;
+    int32_t n_audio_layer;
+    int32_t n_text_ctx;
+    int32_t n_text_state;
+    int32_t n_text_head;
+    int32_t n_text_layer;
+    int32_t n_mels;
+    int32_t ftype;
+    int32_t n_tensor_types;   // Number of distinct tensor types
+    int64_t n_tensors;
+    int64_t n_params;
+    uint64_t tensor_bytes;    // Total tensor data size
+};
+
+// Predicted resident memory for a whisper context
+struct whisper_memory_estimate {
+    uint64_t weights_bytes;
+    uint64_t kv_cache_bytes;  // Self-attention, cross-attention and padding caches
+    uint64_t compute_bytes;   // Mel, encoder and decoder compute buffers
+    uint64_t total_bytes;
+};
+
+// Returns 0 on success, non-zero on error
+int whisper_model_inspect_wrapper(const char * path_model, struct whisper_model_info * info);
+// audio_ctx: encoder context in frames (0 for the model default)
+struct whisper_memory_estimate whisper_model_estimate_memory_wrapper(const struct whisper_model_info * info, int audio_ctx);
+
 // Context Management
 struct whisper_context_params * whisper_context_default_params_by_ref_wrapper(void);
 void whisper_free_context_params_wrapper(struct whisper_context_params * params);
@@ -40,10 +76,36 @@ void whisper_full_params_set_print_special(struct whisper_full_params * params,
 void whisper_full_params_set_print_progress(struct whisper_full_params * params, bool print_progress);
 void whisper_full_params_set_print_realtime(struct whisper_full_params * params, bool print_realtime);
 void whisper_full_params_set_print_timestamps(struct whisper_full_params * params, bool print_timestamps);
+void whisper_full_params_set_token_timestamps(struct whisper_full_params * params, bool token_timestamps);
+
+// Decoding Setters
+// audio_ctx: encoder context in frames (0 = model default of 1500, i.e. 30 s at 50 frames/s)
+void whisper_full_params_set_audio_ctx(struct whisper_full_params * params, int audio_ctx);
+void whisper_full_params_set_max_tokens(struct whisper_full_params * params, int max_tokens);
+void whisper_full_params_set_best_of(struct whisper_full_params * params, int best_of);
+void whisper_full_params_set_beam_size(struct whisper_full_params * params, int beam_size);
+void whisper_full_params_set_temperature(struct whisper_full_params * params, float temperature);
+// temperature_inc: step for temperature fallback (0 disables fallback)
+void whisper_full_params_set_temperature_inc(struct whisper_full_params * params, float temperature_inc);
+void whisper_full_params_set_entropy_thold(struct whisper_full_params * params, float entropy_thold);
+void whisper_full_params_set_logprob_thold(struct whisper_full_params * params, float logprob_thold);
+void whisper_full_params_set_no_speech_thold(struct whisper_full_params * params, float no_speech_thold);
+// initial_prompt must stay valid until whisper_full returns
+void whisper_full_params_set_initial_prompt(struct whisper_full_params * params, const char * initial_prompt);
+
+// Adaptive Encoder Context
+// Encoder frames for n_samples of 16 kHz audio plus a safety margin, rounded up to a
+// multiple of 64 and capped at the model's n_audio_ctx
+int whisper_adaptive_audio_ctx_wrapper(struct whisper_context * ctx, int n_samples);
+void whisper_full_params_set_adaptive_audio_ctx(struct whisper_full_params * params, struct whisper_context * ctx, int n_samples);
 
 // Transcription
 int whisper_full_wrapper(struct whisper_context * ctx, struct whisper_full_params * params, const float * samples, int n_samples);
 int whisper_full_n_segments_wrapper(const struct whisper_context * ctx);
 const char * whisper_full_get_segment_text_wrapper(const struct whisper_context * ctx, int i_segment);
 
+// Spool Transcription
+// Converts a window of a PCM16 spool to float and transcribes it
+int whisper_full_from_spool_wrapper(struct whisper_context * ctx, struct whisper_full_params * params, const struct audio_spool_reader * reader, int64_t offset, int n_samples);
+
 #endif /* whisper_wrapper_h */
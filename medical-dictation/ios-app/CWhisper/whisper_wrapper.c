@@ -6,7 +6,137 @@
 //
 
 #include "include/whisper_wrapper.h"
+#include "include/audio_spool.h"
 #include "whisper.h"
+#include "ggml.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+
+// MARK: - Model Inspection
+
+static bool read_i32(FILE * f, int32_t * value) {
+    return fread(value, sizeof(*value), 1, f) == 1;
+}
+
+int whisper_model_inspect_wrapper(const char * path_model, struct whisper_model_info * info) {
+    if (!path_model || !info) return -1;
+    memset(info, 0, sizeof(*info));
+    
+    FILE * f = fopen(path_model, "rb");
+    if (!f) return -1;
+    
+    int result = -1;
+    uint32_t magic = 0;
+    if (fread(&magic, sizeof(magic), 1, f) != 1 || magic != GGML_FILE_MAGIC) goto done;
+    
+    // Hyperparameters, in file order
+    int32_t * hparams[] = {
+        &info->n_vocab, &info->n_audio_ctx, &info->n_audio_state, &info->n_audio_head, &info->n_audio_layer,
+        &info->n_text_ctx, &info->n_text_state, &info->n_text_head, &info->n_text_layer, &info->n_mels, &info->ftype
+    };
+    for (size_t i = 0; i < sizeof(hparams) / sizeof(hparams[0]); i++) {
+        if (!read_i32(f, hparams[i])) goto done;
+    }
+    info->ftype %= GGML_QNT_VERSION_FACTOR;
+    
+    // Skip the mel filterbank
+    int32_t n_mel = 0, n_fft = 0;
+    if (!read_i32(f, &n_mel) || !read_i32(f, &n_fft)) goto done;
+    if (fseeko(f, (off_t)n_mel * n_fft * sizeof(float), SEEK_CUR) != 0) goto done;
+    
+    // Skip the vocab
+    int32_t n_vocab = 0;
+    if (!read_i32(f, &n_vocab)) goto done;
+    for (int32_t i = 0; i < n_vocab; i++) {
+        uint32_t len = 0;
+        if (fread(&len, sizeof(len), 1, f) != 1 || fseeko(f, len, SEEK_CUR) != 0) goto done;
+    }
+    
+    // Walk the tensor infos, seeking over the data
+    uint64_t bytes_by_type[GGML_TYPE_COUNT] = {0};
+    int32_t n_dims = 0;
+    while (read_i32(f, &n_dims)) {
+        int32_t name_len = 0, ttype = 0;
+        if (!read_i32(f, &name_len) || !read_i32(f, &ttype)) goto done;
+        if (n_dims < 1 || n_dims > 4 || ttype < 0 || ttype >= GGML_TYPE_COUNT) goto done;
+        
+        int64_t n_elements = 1;
+        for (int32_t i = 0; i < n_dims; i++) {
+            int32_t ne = 0;
+            if (!read_i32(f, &ne)) goto done;
+            n_elements *= ne;
+        }
+        
+        enum ggml_type type = (enum ggml_type)ttype;
+        uint64_t size = (uint64_t)(n_elements / ggml_blck_size(type)) * ggml_type_size(type);
+        if (fseeko(f, (off_t)name_len + (off_t)size, SEEK_CUR) != 0) goto done;
+        
+        info->n_tensors++;
+        info->n_params += n_elements;
+        info->tensor_bytes += size;
+        bytes_by_type[type] += size;
+    }
+    
+    int dominant = -1;
+    for (int t = 0; t < GGML_TYPE_COUNT; t++) {
+        if (bytes_by_type[t] == 0) continue;
+        info->n_tensor_types++;
+        if (dominant < 0 || bytes_by_type[t] > bytes_by_type[dominant]) {
+            dominant = t;
+        }
+    }
+    if (dominant >= 0) {
+        snprintf(info->dominant_type, sizeof(info->dominant_type), "%s", ggml_type_name((enum ggml_type)dominant));
+    }
+    
+    // Model size from the encoder depth; large-v3 has 128 mel bins and turbo a 4-layer decoder
+    const char * type = "unknown";
+    switch (info->n_audio_layer) {
+        case 4:  type = "tiny";   break;
+        case 6:  type = "base";   break;
+        case 12: type = "small";  break;
+        case 24: type = "medium"; break;
+        case 32: type = "large";  break;
+    }
+    snprintf(info->model_type, sizeof(info->model_type), "%s%s%s", type,
+             info->n_audio_layer == 32 && info->n_mels == 128 ? "-v3" : "",
+             info->n_audio_layer == 32 && info->n_text_layer == 4 ? "-turbo" : "");
+    
+    result = info->n_tensors > 0 ? 0 : -1;
+    
+done:
+    fclose(f);
+    return result;
+}
+
+struct whisper_memory_estimate whisper_model_estimate_memory_wrapper(const struct whisper_model_info * info, int audio_ctx) {
+    struct whisper_memory_estimate estimate = {0};
+    if (!info) return estimate;
+    
+    uint64_t n_audio_ctx = audio_ctx > 0 && audio_ctx < info->n_audio_ctx ? (uint64_t)audio_ctx : (uint64_t)info->n_audio_ctx;
+    uint64_t f16 = sizeof(uint16_t);
+    
+    estimate.weights_bytes = info->tensor_bytes;
+    
+    // whisper.cpp sizes the self-attention cache at 3x the text context
+    uint64_t kv_self = 3ull * info->n_text_ctx * info->n_text_layer * info->n_text_state * 2 * f16;
+    uint64_t kv_cross = n_audio_ctx * info->n_text_layer * info->n_text_state * 2 * f16;
+    uint64_t kv_pad = n_audio_ctx * info->n_audio_state * 2 * f16;
+    estimate.kv_cache_bytes = kv_self + kv_cross + kv_pad;
+    
+    // Encoder attention scores dominate; the conv stem, activations and mel are linear in audio_ctx
+    uint64_t kq = n_audio_ctx * n_audio_ctx * info->n_audio_head;
+    uint64_t activations = 8ull * n_audio_ctx * info->n_audio_state;
+    uint64_t mel = 2ull * n_audio_ctx * info->n_mels;
+    uint64_t logits = (uint64_t)info->n_text_ctx * info->n_vocab;
+    estimate.compute_bytes = (kq + activations + mel + logits) * sizeof(float);
+    
+    estimate.total_bytes = estimate.weights_bytes + estimate.kv_cache_bytes + estimate.compute_bytes;
+    return estimate;
+}
 
 // MARK: - Context Management
 
@@ -74,6 +204,76 @@ void whisper_full_params_set_print_timestamps(struct whisper_full_params * param
     if (params) params->print_timestamps = print_timestamps;
 }
 
+void whisper_full_params_set_token_timestamps(struct whisper_full_params * params, bool token_timestamps) {
+    if (params) params->token_timestamps = token_timestamps;
+}
+
+// MARK: - Decoding Setters
+
+void whisper_full_params_set_audio_ctx(struct whisper_full_params * params, int audio_ctx) {
+    if (params) params->audio_ctx = audio_ctx;
+}
+
+void whisper_full_params_set_max_tokens(struct whisper_full_params * params, int max_tokens) {
+    if (params) params->max_tokens = max_tokens;
+}
+
+void whisper_full_params_set_best_of(struct whisper_full_params * params, int best_of) {
+    if (params) params->greedy.best_of = best_of;
+}
+
+void whisper_full_params_set_beam_size(struct whisper_full_params * params, int beam_size) {
+    if (params) params->beam_search.beam_size = beam_size;
+}
+
+void whisper_full_params_set_temperature(struct whisper_full_params * params, float temperature) {
+    if (params) params->temperature = temperature;
+}
+
+void whisper_full_params_set_temperature_inc(struct whisper_full_params * params, float temperature_inc) {
+    if (params) params->temperature_inc = temperature_inc;
+}
+
+void whisper_full_params_set_entropy_thold(struct whisper_full_params * params, float entropy_thold) {
+    if (params) params->entropy_thold = entropy_thold;
+}
+
+void whisper_full_params_set_logprob_thold(struct whisper_full_params * params, float logprob_thold) {
+    if (params) params->logprob_thold = logprob_thold;
+}
+
+void whisper_full_params_set_no_speech_thold(struct whisper_full_params * params, float no_speech_thold) {
+    if (params) params->no_speech_thold = no_speech_thold;
+}
+
+void whisper_full_params_set_initial_prompt(struct whisper_full_params * params, const char * initial_prompt) {
+    if (params) params->initial_prompt = initial_prompt;
+}
+
+// MARK: - Adaptive Encoder Context
+
+// The encoder produces 50 frames per second of 16 kHz audio (one per 320 samples)
+#define WHISPER_SAMPLES_PER_FRAME 320
+// Extra frames so speech at the very end of a chunk is not cut off. 64 frames (1.28 s)
+// is one rounding step, so a 3 s chunk (150 frames) lands on 256 - a starting point,
+// not a measured value: compare the fixed 256/384 settings of tools/whisper_ctx_bench
+// against "adaptive" on real encounters before relying on it
+#define WHISPER_AUDIO_CTX_MARGIN 64
+
+int whisper_adaptive_audio_ctx_wrapper(struct whisper_context * ctx, int n_samples) {
+    if (!ctx || n_samples <= 0) return 0;
+    
+    int n_audio_ctx = whisper_n_audio_ctx(ctx);
+    int frames = (n_samples + WHISPER_SAMPLES_PER_FRAME - 1) / WHISPER_SAMPLES_PER_FRAME + WHISPER_AUDIO_CTX_MARGIN;
+    frames = (frames + 63) / 64 * 64;
+    
+    return frames < n_audio_ctx ? frames : n_audio_ctx;
+}
+
+void whisper_full_params_set_adaptive_audio_ctx(struct whisper_full_params * params, struct whisper_context * ctx, int n_samples) {
+    if (params) params->audio_ctx = whisper_adaptive_audio_ctx_wrapper(ctx, n_samples);
+}
+
 // MARK: - Transcription
 
 int whisper_full_wrapper(struct whisper_context * ctx, struct whisper_full_params * params, const float * samples, int n_samples) {
@@ -88,3 +288,18 @@ int whisper_full_n_segments_wrapper(const struct whisper_context * ctx) {
 const char * whisper_full_get_segment_text_wrapper(const struct whisper_context * ctx, int i_segment) {
     return whisper_full_get_segment_text(ctx, i_segment);
 }
+
+// MARK: - Spool Transcription
+
+int whisper_full_from_spool_wrapper(struct whisper_context * ctx, struct whisper_full_params * params, const struct audio_spool_reader * reader, int64_t offset, int n_samples) {
+    if (!ctx || !params || !reader || n_samples <= 0) return -1;
+    
+    float * window = (float *)malloc((size_t)n_samples * sizeof(float));
+    if (!window) return -1;
+    
+    int n = audio_spool_reader_read(reader, offset, n_samples, window);
+    int result = n > 0 ? whisper_full(ctx, *params, window, n) : -1;
+    
+    free(window);
+    return result;
+}
@@ -15,7 +15,7 @@ let package = Package(
             name: "CWhisper",
             dependencies: [],
             path: "CWhisper",
-            sources: ["whisper_wrapper.c"],
+            sources: ["whisper_wrapper.c", "audio_spool.c"],
             publicHeadersPath: "include",
             cSettings: [
                 .headerSearchPath("../../scripts/build/whisper.cpp/include"),
@@ -14,6 +14,9 @@
 // Whisper wrapper
 #import "CWhisper/include/whisper_wrapper.h"
 
+// Encounter audio spool
+#import "CWhisper/include/audio_spool.h"
+
 // Import llama.h for types
 #import <llama.h>
 
@@ -1,11 +1,21 @@
 import Foundation
 import Combine
+#if canImport(UIKit)
+import UIKit
+#endif
 
 /// LLM Processor - Real llama.cpp integration for on-device inference
 @MainActor
 final class LLMProcessor: ObservableObject {
     @Published var structuredNote: StructuredNote?
-    @Published var isProcessing = false
+    @Published var isProcessing = false {
+        didSet {
+            if !isProcessing && unloadWhenIdle {
+                unloadWhenIdle = false
+                unloadModel()
+            }
+        }
+    }
     @Published var modelStatus: ModelStatus = .notLoaded
     @Published var currentTemplate: NoteTemplate = .soap
     @Published var generationProgress: String = ""
@@ -19,6 +29,17 @@ final class LLMProcessor: ObservableObject {
     private var isModelLoaded = false
     private var currentTier: PerformanceTier = .powerSaver
     
+    // LoRA adapters loaded against the current base model, keyed by file name
+    private var loraAdapters: [String: OpaquePointer] = [:]
+    @Published private(set) var activeAdapter: String?
+    
+    /// Set when the last note could not use its template's specialty adapter
+    @Published private(set) var adapterWarning: String?
+    
+    // Set when an unload is requested mid-generation; the model is unloaded once it finishes
+    private var unloadWhenIdle = false
+    private var memoryWarningObserver: NSObjectProtocol?
+    
     // Generation settings - use nonisolated(unsafe) for C struct that is only accessed from MainActor
     private var maxTokens: Int32 = 1024  // Reduced for iOS memory constraints
     private nonisolated(unsafe) var samplerConfig = llama_wrapper_default_sampler_config()
@@ -42,19 +63,20 @@ final class LLMProcessor: ObservableObject {
                 return """
 You are a medical scribe. Convert the following patient encounter transcript into a structured SOAP note.
 Format:
-**Subjective:** Patient's complaints, history, symptoms
-**Objective:** Vital signs, physical exam findings, test results
-**Assessment:** Diagnosis/differential diagnosis
-**Plan:** Treatment plan, medications, follow-up
+Subjective: Patient's complaints, history, symptoms
+Objective: Vital signs, physical exam findings, test results
+Assessment: Diagnosis/differential diagnosis
+Plan: Treatment plan, medications, follow-up
 
-Be concise but complete. Use medical terminology appropriately.
+Separate sections with a blank line. Be concise but complete. Use medical terminology appropriately.
 
 Transcript:
 """
             case .hp:
                 return """
 You are a medical scribe. Convert the following patient encounter transcript into a complete History and Physical (H&P) note.
-Include: Chief Complaint, History of Present Illness, Past Medical History, Medications, Allergies, Family History, Social History, Review of Systems, Physical Exam, Assessment, and Plan.
+Include, in order: Identifying Data, Chief Complaint, History of Present Illness, Past Medical History, Medications, Allergies, Family History, Social History, Review of Systems, Physical Exam, Assessment, and Plan.
+Start each section with its name followed by a colon and separate sections with a blank line.
 
 Transcript:
 """
@@ -65,6 +87,26 @@ Transcript:
             }
         }
         
+        /// Required output sections in order, with per-section token budgets
+        /// Empty for free-form templates, which are generated unconstrained
+        var sectionSchema: [NoteSection] {
+            switch self {
+            case .soap:
+                return [
+                    NoteSection(header: "Subjective", maxTokens: 256),
+                    NoteSection(header: "Objective", maxTokens: 192),
+                    NoteSection(header: "Assessment", maxTokens: 128),
+                    NoteSection(header: "Plan", maxTokens: 192)
+                ]
+            case .hp:
+                return HPTemplate.HPSection.allCases.map {
+                    NoteSection(header: $0.rawValue, maxTokens: $0.tokenBudget)
+                }
+            case .summary, .bullets:
+                return []
+            }
+        }
+        
         /// Format the output into sections
         func parseSections(from text: String) -> [String: String] {
             var sections: [String: String] = [:]
@@ -146,7 +188,7 @@ Transcript:
             var currentContent: [String] = []
             
             let sectionHeaders = [
-                "chief complaint", "history of present illness", "hpi",
+                "identifying data", "chief complaint", "history of present illness", "hpi",
                 "past medical history", "pmh", "medications", "meds",
                 "allergies", "family history", "social history",
                 "review of systems", "ros", "physical exam", "exam",
@@ -189,11 +231,29 @@ Transcript:
         }
     }
     
+    /// A required note section for constrained generation
+    struct NoteSection: Sendable {
+        let header: String
+        let maxTokens: Int32
+    }
+    
     // MARK: - Initialization
     
     init() {
         // Initialize llama backend
         llama_wrapper_backend_init()
+        
+        #if canImport(UIKit)
+        memoryWarningObserver = NotificationCenter.default.addObserver(
+            forName: UIApplication.didReceiveMemoryWarningNotification,
+            object: nil,
+            queue: .main
+        ) { [weak self] _ in
+            MainActor.assumeIsolated {
+                self?.handleMemoryWarning()
+            }
+        }
+        #endif
     }
     
     nonisolated func cleanup() {
@@ -284,6 +344,21 @@ Transcript:
             return
         }
         
+        // Predict resident memory from the GGUF header before spending seconds on a load that won't fit
+        var info = llama_model_info()
+        if llama_wrapper_inspect_model(foundPath, &info, nil, 0) == 0 {
+            let estimate = llama_wrapper_estimate_memory(&info, tier.contextWindow, 1)
+            let params = String(format: "%.1fB", Double(info.n_params) / 1e9)
+            print("🔎 \(stringFromCArray(info.name)) [\(stringFromCArray(info.architecture)), \(stringFromCArray(info.dominant_type))]: \(params) params, trained ctx \(info.n_ctx_train)")
+            print("   Predicted memory: \(formatBytes(estimate.total_bytes)) (weights \(formatBytes(estimate.weights_bytes)), KV \(formatBytes(estimate.kv_cache_bytes)), compute \(formatBytes(estimate.compute_bytes)))")
+            
+            if let available = ProcessInfo.processInfo.availableMemoryBytes, estimate.total_bytes > available {
+                modelStatus = .error("Not enough memory for \(tier.rawValue): needs \(formatBytes(estimate.total_bytes)), \(formatBytes(available)) available")
+                print("❌ Skipping load - predicted memory exceeds available memory")
+                return
+            }
+        }
+        
         // Update progress
         modelStatus = .loading(progress: 0.1)
         
@@ -359,7 +434,21 @@ Transcript:
     }
     
     /// Unload the model and free resources
+    /// Deferred until the current generation or batch run finishes, since it holds the pointers
     func unloadModel() {
+        if isProcessing {
+            print("⏳ Generation in progress, unloading model when done")
+            unloadWhenIdle = true
+            return
+        }
+        
+        // Adapters must be freed before their base model
+        for lora in loraAdapters.values {
+            llama_wrapper_lora_free(lora)
+        }
+        loraAdapters.removeAll()
+        activeAdapter = nil
+        
         if let ctx = context {
             llama_wrapper_free_context(ctx)
             context = nil
@@ -374,6 +463,16 @@ Transcript:
         print("🗑️ Model unloaded")
     }
     
+    /// Free the model (and its adapters) when iOS reports memory pressure
+    /// The model stays loaded between notes otherwise, so consecutive notes skip the reload
+    /// and specialty adapters stay cached
+    private func handleMemoryWarning() {
+        guard isModelLoaded else { return }
+        
+        print("⚠️ Memory warning, unloading model")
+        unloadModel()
+    }
+    
     /// Configure the sampler with performance tier settings
     private func configureSampler(tier: PerformanceTier) {
         samplerConfig = llama_wrapper_default_sampler_config()
@@ -390,14 +489,25 @@ Transcript:
     /// - Parameters:
     ///   - transcript: The raw transcribed text
     ///   - template: The note template to use (defaults to currentTemplate)
+    ///   - customTemplate: Rotation template whose specialty adapter to apply (nil, or an adapter
+    ///     that can't be loaded, runs the base model - see adapterWarning)
     /// - Returns: A StructuredNote containing the generated note
-    func processTranscript(_ transcript: String, template: NoteTemplate? = nil) async -> StructuredNote? {
+    func processTranscript(
+        _ transcript: String,
+        template: NoteTemplate? = nil,
+        customTemplate: CustomTemplate? = nil
+    ) async -> StructuredNote? {
         let templateToUse = template ?? currentTemplate
         
-        guard isModelLoaded, let ctx = context, vocab != nil else {
+        guard isModelLoaded, context != nil, vocab != nil else {
             print("⚠️ Model not loaded, cannot process transcript")
             return nil
         }
+        // Generation and batch runs share the main context
+        guard !isProcessing else {
+            print("⚠️ Already processing, cannot process transcript")
+            return nil
+        }
         
         isProcessing = true
         generationProgress = "Preparing prompt..."
@@ -406,15 +516,10 @@ Transcript:
         
         print("🧠 Processing with template: \(templateToUse.rawValue)")
         
-        // For Qwen (Balanced tier), first translate if needed
-        var processedTranscript = transcript
-        if currentTier == .balanced {
-            generationProgress = "Translating if needed..."
-            processedTranscript = await translateIfNeeded(transcript: transcript)
-        }
+        await applyAdapter(of: customTemplate)
+        guard let ctx = context else { return nil }
         
-        // Build prompt with template
-        let prompt = buildPrompt(transcript: processedTranscript, template: templateToUse)
+        let prompt = await preparePrompt(transcript: transcript, template: templateToUse)
         
         // Clear KV cache for fresh generation
         llama_wrapper_clear_kv_cache(ctx)
@@ -425,6 +530,7 @@ Transcript:
         let output = await generateText(
             prompt: prompt,
             maxTokens: maxTokens,
+            sections: templateToUse.sectionSchema,
             onToken: { [weak self] token in
                 Task { @MainActor in
                     self?.generatedText.append(token)
@@ -447,14 +553,23 @@ Transcript:
         
         self.structuredNote = note
         
-        // CRITICAL: Unload model immediately after generation to free memory
-        // This prevents iOS from killing the app due to memory pressure
-        print("🧹 Auto-unloading model to free memory...")
-        unloadModel()
-        
+        // The model stays loaded for the next note; memory warnings unload it (handleMemoryWarning)
         return note
     }
     
+    /// Prepare the generation prompt for a transcript
+    /// Shared by single, streaming and batch generation so every path sees the same input
+    private func preparePrompt(transcript: String, template: NoteTemplate) async -> String {
+        // For Qwen (Balanced tier), first translate if needed
+        var processedTranscript = transcript
+        if currentTier == .balanced {
+            generationProgress = "Translating if needed..."
+            processedTranscript = await translateIfNeeded(transcript: transcript)
+        }
+        
+        return buildPrompt(transcript: processedTranscript, template: template)
+    }
+    
     /// Build the prompt for the LLM
     private func buildPrompt(transcript: String, template: NoteTemplate) -> String {
         let systemPrompt = template.systemPrompt
@@ -471,9 +586,13 @@ Transcript:
     /// Translate transcript to English if needed (for multilingual models like Qwen)
     private func translateIfNeeded(transcript: String) async -> String {
         // Check if transcript appears to be non-English (simple heuristic)
-        let spanishWords = ["el", "la", "los", "las", "es", "son", "y", "o", "con", "por", "para", "que", "como", "pero", "bien", "muy", "aquí", "ahora", "hoy", "dolor", "cabeza", "estómago", "malestar", "náusea", "vómito", "fiebre", "tos", "gripa", "gripe"]
-        let lowerTranscript = transcript.lowercased()
-        let hasSpanish = spanishWords.contains { lowerTranscript.contains($0) }
+        let spanishWords: Set<String> = ["el", "la", "los", "las", "es", "son", "y", "o", "con", "por", "para", "que", "como", "pero", "bien", "muy", "aquí", "ahora", "hoy", "dolor", "cabeza", "estómago", "malestar", "náusea", "vómito", "fiebre", "tos", "gripa", "gripe"]
+        // Match whole words - substrings like "o", "es" or "la" occur in almost any English text.
+        // Two distinct hits keep a stray "la" or "con" from costing a translation pass
+        let words = transcript.lowercased()
+            .components(separatedBy: CharacterSet.letters.inverted)
+            .filter { !$0.isEmpty }
+        let hasSpanish = spanishWords.intersection(words).count >= 2
         
         guard hasSpanish else {
             print("📝 No translation needed (appears to be English)")
@@ -513,10 +632,12 @@ Output only the English translation, no explanations.<|im_end|>
                 translationPrompt,
                 512,  // Shorter limit for translation
                 localSamplerConfig,
+                nil,  // Unconstrained
                 nil,
                 nil,
                 &outputBuffer,
-                65536
+                65536,
+                nil
             )
             
             if generatedCount > 0 {
@@ -533,36 +654,50 @@ Output only the English translation, no explanations.<|im_end|>
     /// - Parameters:
     ///   - prompt: The input prompt
     ///   - maxTokens: Maximum tokens to generate
+    ///   - sections: Required output sections (empty for unconstrained output)
     ///   - onToken: Optional callback for each generated token
     /// - Returns: The generated text
     private func generateText(
         prompt: String,
         maxTokens: Int32,
+        sections: [NoteSection] = [],
         onToken: ((String) -> Void)? = nil
     ) async -> String {
         guard let ctx = context, let vocab = vocab else { return "" }
         
         // Capture sampler config locally to avoid MainActor isolation issues
         let localSamplerConfig = self.samplerConfig
+        let reasoning = currentTier.reasoningMode
+        let reasoningBudget = currentTier.reasoningBudget
         
         return await Task.detached(priority: .userInitiated) { [weak self] () -> String in
             guard let self = self else { return "" }
             
             var outputBuffer = [CChar](repeating: 0, count: 65536)
+            var stats = llama_generation_stats()
             
             // Generate using llama_wrapper_generate without callback
             // C callbacks cannot capture Swift context - use output buffer instead
-            let generatedCount = llama_wrapper_generate(
-                ctx,
-                vocab,
-                prompt,
-                maxTokens,
-                localSamplerConfig,
-                nil,  // No token callback - C callbacks can't capture Swift context
-                nil,
-                &outputBuffer,
-                65536
-            )
+            let generatedCount = withGenerationOptions(
+                sections: sections,
+                reasoning: reasoning,
+                reasoningBudget: reasoningBudget
+            ) { options in
+                llama_wrapper_generate(
+                    ctx,
+                    vocab,
+                    prompt,
+                    maxTokens,
+                    localSamplerConfig,
+                    options,
+                    nil,  // No token callback - C callbacks can't capture Swift context
+                    nil,
+                    &outputBuffer,
+                    65536,
+                    &stats
+                )
+            }
+            logGenerationStats(stats)
             
             if generatedCount > 0 {
                 let result = String(cString: outputBuffer)
@@ -590,6 +725,45 @@ Output only the English translation, no explanations.<|im_end|>
     }
 }
 
+// MARK: - Generation Options
+
+/// Call `body` with C generation options built from a section schema and reasoning mode
+/// The options (and the header strings they point to) are only valid inside `body`
+private func withGenerationOptions<R>(
+    sections: [LLMProcessor.NoteSection],
+    reasoning: llama_reasoning_mode = LLAMA_REASONING_KEEP,
+    reasoningBudget: Int32 = 0,
+    _ body: (UnsafePointer<llama_generation_options>?) -> R
+) -> R {
+    guard !sections.isEmpty || reasoning != LLAMA_REASONING_KEEP else { return body(nil) }
+    
+    let headers = sections.map { strdup($0.header) }
+    defer { headers.forEach { free($0) } }
+    
+    let cSections = zip(headers, sections).map { header, section in
+        llama_note_section(header: UnsafePointer(header), max_tokens: section.maxTokens)
+    }
+    
+    return cSections.withUnsafeBufferPointer { buffer in
+        var options = llama_generation_options(
+            grammar: nil,
+            grammar_root: nil,
+            sections: buffer.baseAddress,
+            n_sections: Int32(buffer.count),
+            reasoning: reasoning,
+            reasoning_budget: reasoningBudget
+        )
+        return withUnsafePointer(to: &options) { body($0) }
+    }
+}
+
+/// Log prompt, answer and reasoning token counts for a generation
+private func logGenerationStats(_ stats: llama_generation_stats) {
+    let answerTokens = stats.n_generated_tokens - stats.n_reasoning_tokens
+    print("📊 Prompt: \(stats.n_prompt_tokens) tokens in \(Int(stats.t_prompt_ms)) ms")
+    print("   Generated: \(answerTokens) tokens + \(stats.n_reasoning_tokens) reasoning in \(Int(stats.t_generate_ms)) ms")
+}
+
 // MARK: - Model Load Result
 
 /// Internal enum for model loading results
@@ -661,6 +835,126 @@ extension LLMProcessor {
         var repeatLastN: Int32 {
             return 64
         }
+        
+        /// How <think> blocks are handled (only DeepSeek-R1 emits them)
+        var reasoningMode: llama_reasoning_mode {
+            switch self {
+            case .powerSaver: return LLAMA_REASONING_KEEP
+            case .balanced: return LLAMA_REASONING_KEEP
+            case .maximum: return LLAMA_REASONING_BUDGET
+            }
+        }
+        
+        /// Maximum reasoning tokens before the think block is closed
+        var reasoningBudget: Int32 {
+            switch self {
+            case .powerSaver, .balanced: return 0
+            case .maximum: return 256
+            }
+        }
+        
+        /// Notes decoded together when regenerating in bulk (each needs its own context window of KV cache)
+        var batchParallelism: UInt32 {
+            switch self {
+            case .powerSaver: return 4
+            case .balanced: return 2
+            case .maximum: return 2
+            }
+        }
+    }
+}
+
+// MARK: - Specialty Adapters
+
+extension LLMProcessor {
+    /// File size of all loaded LoRA adapters in bytes (approximates their memory)
+    var adapterFileBytes: Int {
+        loraAdapters.values.reduce(0) { $0 + Int(llama_wrapper_lora_file_size($1)) }
+    }
+    
+    /// Attach a specialty LoRA adapter on top of the loaded base model
+    /// Adapters are loaded once per base model; switching afterwards only re-attaches them
+    /// - Parameter fileName: Adapter .gguf file name, or nil to run the base model alone
+    /// - Returns: true if the requested adapter (or none) is active
+    @discardableResult
+    func setAdapter(_ fileName: String?) async -> Bool {
+        guard isModelLoaded, let model = model, let ctx = context else {
+            print("⚠️ Model not loaded, cannot attach adapter")
+            return false
+        }
+        
+        if activeAdapter == fileName { return true }
+        
+        llama_wrapper_lora_detach_all(ctx)
+        activeAdapter = nil
+        
+        guard let fileName = fileName else {
+            llama_wrapper_clear_kv_cache(ctx)
+            print("🧩 Adapter detached, using base model")
+            return true
+        }
+        
+        let lora: OpaquePointer
+        if let cached = loraAdapters[fileName] {
+            lora = cached
+        } else {
+            guard let path = findAdapterPath(fileName) else {
+                print("⚠️ Adapter not found: \(fileName)")
+                return false
+            }
+            
+            let start = Date()
+            let loaded = await Task.detached(priority: .userInitiated) { [path] in
+                llama_wrapper_lora_load(model, path)
+            }.value
+            
+            guard let loaded = loaded else {
+                print("❌ Failed to load adapter \(fileName) (built for a different base model?)")
+                return false
+            }
+            
+            loraAdapters[fileName] = loaded
+            lora = loaded
+            
+            let size = ByteCountFormatter.string(fromByteCount: Int64(llama_wrapper_lora_file_size(loaded)), countStyle: .memory)
+            print("🧩 Loaded adapter \(fileName) (\(size)) in \(Int(Date().timeIntervalSince(start) * 1000)) ms")
+        }
+        
+        guard llama_wrapper_lora_attach(ctx, lora, 1.0) == 0 else {
+            print("❌ Failed to attach adapter \(fileName)")
+            return false
+        }
+        
+        // Cached keys/values were computed without the adapter
+        llama_wrapper_clear_kv_cache(ctx)
+        activeAdapter = fileName
+        print("🧩 Adapter attached: \(fileName)")
+        return true
+    }
+    
+    /// Attach a template's specialty adapter, falling back to the base model if it can't be used
+    /// Attaching or switching an adapter clears the KV cache
+    private func applyAdapter(of customTemplate: CustomTemplate?) async {
+        adapterWarning = nil
+        let fileName = customTemplate?.loraAdapter
+        
+        if await setAdapter(fileName) { return }
+        
+        // Missing, built for another base model, or failed to attach - still write the note
+        adapterWarning = "Specialty adapter \(fileName ?? "") unavailable, note generated with the base model"
+        await setAdapter(nil)
+    }
+    
+    /// Find an adapter file (downloaded adapters first, then the bundle)
+    private func findAdapterPath(_ fileName: String) -> String? {
+        let possiblePaths = [
+            FileManager.default.urls(for: .documentDirectory, in: .userDomainMask)
+                .first?.appendingPathComponent("models/adapters/\(fileName)").path,
+            Bundle.main.path(forResource: fileName, ofType: nil),
+            Bundle.main.bundlePath + "/scripts/build/models/adapters/" + fileName
+        ].compactMap { $0 }
+        
+        return possiblePaths.first(where: { FileManager.default.fileExists(atPath: $0) })
     }
 }
 
@@ -671,27 +965,37 @@ extension LLMProcessor {
     /// - Parameters:
     ///   - transcript: The raw transcribed text
     ///   - template: The note template to use
+    ///   - customTemplate: Rotation template whose specialty adapter to apply (nil, or an adapter
+    ///     that can't be loaded, runs the base model - see adapterWarning)
     ///   - onToken: Callback called for each generated token
     /// - Returns: A StructuredNote containing the generated note
     func processTranscriptStreaming(
         _ transcript: String,
         template: NoteTemplate? = nil,
+        customTemplate: CustomTemplate? = nil,
         onToken: @escaping (String) -> Void
     ) async -> StructuredNote? {
         let templateToUse = template ?? currentTemplate
         
-        guard isModelLoaded, let ctx = context, vocab != nil else {
+        guard isModelLoaded, context != nil, vocab != nil else {
             print("⚠️ Model not loaded, cannot process transcript")
             return nil
         }
+        // Generation and batch runs share the main context
+        guard !isProcessing else {
+            print("⚠️ Already processing, cannot process transcript")
+            return nil
+        }
         
         isProcessing = true
         generationProgress = "Preparing prompt..."
         generatedText = ""
         defer { isProcessing = false }
         
-        // Build prompt
-        let prompt = buildPrompt(transcript: transcript, template: templateToUse)
+        await applyAdapter(of: customTemplate)
+        guard let ctx = context else { return nil }
+        
+        let prompt = await preparePrompt(transcript: transcript, template: templateToUse)
         
         // Clear KV cache
         llama_wrapper_clear_kv_cache(ctx)
@@ -702,6 +1006,7 @@ extension LLMProcessor {
         await generateTextStreaming(
             prompt: prompt,
             maxTokens: maxTokens,
+            sections: templateToUse.sectionSchema,
             onToken: onToken
         )
         
@@ -725,29 +1030,42 @@ extension LLMProcessor {
     private func generateTextStreaming(
         prompt: String,
         maxTokens: Int32,
+        sections: [NoteSection] = [],
         onToken: @escaping (String) -> Void
     ) async {
         guard let ctx = context, let vocab = vocab else { return }
         
         // Capture sampler config locally
         let localSamplerConfig = self.samplerConfig
+        let reasoning = currentTier.reasoningMode
+        let reasoningBudget = currentTier.reasoningBudget
         
         await Task.detached(priority: .userInitiated) {
             var outputBuffer = [CChar](repeating: 0, count: 65536)
+            var stats = llama_generation_stats()
             
             // Generate without callback - C callbacks cannot capture Swift context
             // For true streaming, we'd need a different architecture with a global callback registry
-            llama_wrapper_generate(
-                ctx,
-                vocab,
-                prompt,
-                maxTokens,
-                localSamplerConfig,
-                nil,  // No callback - C callbacks can't capture Swift context
-                nil,
-                &outputBuffer,
-                65536
-            )
+            withGenerationOptions(
+                sections: sections,
+                reasoning: reasoning,
+                reasoningBudget: reasoningBudget
+            ) { options in
+                _ = llama_wrapper_generate(
+                    ctx,
+                    vocab,
+                    prompt,
+                    maxTokens,
+                    localSamplerConfig,
+                    options,
+                    nil,  // No callback - C callbacks can't capture Swift context
+                    nil,
+                    &outputBuffer,
+                    65536,
+                    &stats
+                )
+            }
+            logGenerationStats(stats)
             
             // After generation, call onToken with the full output
             let result = String(cString: outputBuffer)
@@ -757,3 +1075,138 @@ extension LLMProcessor {
         }.value
     }
 }
+
+// MARK: - Batch Regeneration
+
+extension LLMProcessor {
+    /// Regenerate notes from their stored transcripts using continuous batching
+    /// Notes are decoded several at a time in a separate multi-sequence context, and a
+    /// queued note starts as soon as another finishes. Notes are updated in place.
+    /// Notes are regenerated with the base model - specialty adapters are not applied.
+    /// - Parameters:
+    ///   - notes: Notes to regenerate
+    ///   - template: Template to regenerate with (nil keeps each note's own template)
+    /// - Returns: Number of notes regenerated
+    @discardableResult
+    func regenerateNotes(_ notes: [StructuredNote], template: NoteTemplate? = nil) async -> Int {
+        guard isModelLoaded, model != nil, vocab != nil else {
+            print("⚠️ Model not loaded, cannot regenerate notes")
+            return 0
+        }
+        guard !notes.isEmpty else { return 0 }
+        guard !isProcessing else {
+            print("⚠️ Already processing, cannot regenerate notes")
+            return 0
+        }
+        
+        isProcessing = true
+        defer { isProcessing = false }
+        
+        // One batch run per template, since jobs in a run share the section schema
+        let groups = Dictionary(grouping: notes) { template ?? $0.template }
+        var regenerated = 0
+        
+        for (groupTemplate, groupNotes) in groups.sorted(by: { $0.key.rawValue < $1.key.rawValue }) {
+            // Translation (if any) runs on the main context before the batch starts
+            var prompts: [String] = []
+            for note in groupNotes {
+                prompts.append(await preparePrompt(transcript: note.rawTranscript, template: groupTemplate))
+            }
+            
+            generationProgress = "Regenerating \(groupNotes.count) \(groupTemplate.rawValue) notes..."
+            let outputs = await runBatchJobs(prompts: prompts, sections: groupTemplate.sectionSchema)
+            
+            for (note, output) in zip(groupNotes, outputs) where !output.isEmpty {
+                let sections = groupTemplate.parseSections(from: output)
+                note.templateRaw = groupTemplate.rawValue
+                note.sectionsData = (try? JSONEncoder().encode(sections)) ?? Data()
+                note.fullText = formatFullText(sections: sections, template: groupTemplate)
+                note.generatedAt = Date()
+                regenerated += 1
+            }
+        }
+        
+        generationProgress = "Regenerated \(regenerated) of \(notes.count) notes"
+        return regenerated
+    }
+    
+    /// Number of parallel sequences whose KV cache fits in the memory left beside the loaded model
+    private func batchParallelism(maxJobs: Int) -> UInt32 {
+        var nParallel = min(currentTier.batchParallelism, UInt32(max(1, maxJobs)))
+        
+        var info = llama_model_info()
+        guard let path = modelPath, llama_wrapper_inspect_model(path, &info, nil, 0) == 0,
+              let available = ProcessInfo.processInfo.availableMemoryBytes else {
+            return nParallel
+        }
+        
+        // Weights are already resident - only the new context's buffers are allocated
+        while nParallel > 1 {
+            let estimate = llama_wrapper_estimate_memory(&info, currentTier.contextWindow * nParallel, nParallel)
+            if estimate.kv_cache_bytes + estimate.compute_bytes <= available { break }
+            nParallel -= 1
+        }
+        return nParallel
+    }
+    
+    /// Generate one output per prompt in a temporary multi-sequence context
+    /// - Returns: Outputs in prompt order (empty for jobs that failed)
+    private func runBatchJobs(prompts: [String], sections: [NoteSection]) async -> [String] {
+        guard let model = model, let vocab = vocab else { return [] }
+        
+        let nParallel = batchParallelism(maxJobs: prompts.count)
+        let nCtx = currentTier.contextWindow * nParallel
+        let localSamplerConfig = self.samplerConfig
+        let localMaxTokens = self.maxTokens
+        let reasoning = currentTier.reasoningMode
+        let reasoningBudget = currentTier.reasoningBudget
+        
+        return await Task.detached(priority: .userInitiated) { () -> [String] in
+            let nThreads = max(1, min(8, ProcessInfo.processInfo.processorCount - 2))
+            guard let batchCtx = llama_wrapper_new_batch_context(model, nCtx, nParallel, Int32(nThreads), Int32(nThreads)) else {
+                print("❌ Failed to create batch context (\(nParallel) x \(nCtx / nParallel) tokens)")
+                return []
+            }
+            defer { llama_wrapper_free_context(batchCtx) }
+            
+            // No specialty adapter: notes don't record which one produced them, so
+            // reusing the last live note's adapter would apply it to unrelated notes
+            
+            let bufferSize = 65536
+            let cPrompts = prompts.map { strdup($0) }
+            let buffers = prompts.map { _ in UnsafeMutablePointer<CChar>.allocate(capacity: bufferSize) }
+            defer {
+                cPrompts.forEach { free($0) }
+                buffers.forEach { $0.deallocate() }
+            }
+            
+            var stats = llama_batch_run_stats()
+            let outputs = withGenerationOptions(
+                sections: sections,
+                reasoning: reasoning,
+                reasoningBudget: reasoningBudget
+            ) { options -> [String] in
+                var jobs = zip(cPrompts, buffers).map { prompt, buffer in
+                    var job = llama_batch_job()
+                    job.prompt = UnsafePointer(prompt)
+                    job.max_tokens = localMaxTokens
+                    job.options = options
+                    job.output_buffer = buffer
+                    job.output_buffer_size = bufferSize
+                    return job
+                }
+                
+                // No job callback - C callbacks can't capture Swift context
+                _ = llama_wrapper_run_batch_jobs(batchCtx, vocab, &jobs, Int32(jobs.count), localSamplerConfig, nil, nil, &stats)
+                
+                return zip(jobs, buffers).map { job, buffer in
+                    job.status == LLAMA_BATCH_JOB_DONE ? String(cString: buffer) : ""
+                }
+            }
+            
+            print("📦 Batch: \(stats.n_jobs_done) done, \(stats.n_jobs_failed) failed with \(nParallel) sequences in \(Int(stats.t_total_ms)) ms")
+            print("   Throughput: \(Int(stats.prompt_tokens_per_s)) prompt tok/s, \(Int(stats.generated_tokens_per_s)) generated tok/s")
+            return outputs
+        }.value
+    }
+}
@@ -15,6 +15,23 @@ final class TranscriptionEngine: ObservableObject {
     private var transcriptionTask: Task<Void, Never>?
     private var isModelLoaded = false
     
+    /// Size the encoder window to each streaming chunk instead of the full 30 s
+    /// (a 3 s chunk needs 256 of the 1500 encoder frames)
+    /// Off until tools/whisper_ctx_bench results on clinical audio show the WER cost is acceptable
+    var adaptiveAudioContext = false
+    
+    // On-disk PCM16 spool of the current encounter's audio
+    // Writes and fsyncs run on spoolQueue so they never block the audio tap thread
+    private nonisolated(unsafe) var spoolWriter: OpaquePointer?
+    private let spoolQueue = DispatchQueue(label: "com.hxdictate.audio-spool", qos: .utility)
+    private(set) var spoolURL: URL?
+    
+    /// Spools left behind by a crash or an unsaved encounter, oldest first
+    @Published private(set) var recoverableSpools: [URL] = []
+    
+    /// Spools older than this are deleted at launch
+    static let spoolRetentionDays = 7
+    
     enum ModelStatus {
         case notLoaded
         case loading
@@ -44,6 +61,16 @@ final class TranscriptionEngine: ObservableObject {
         }
     }
     
+    // MARK: - Initialization
+    
+    init() {
+        pruneSpools()
+        recoverableSpools = Self.listSpools()
+        if !recoverableSpools.isEmpty {
+            print("💾 Found \(recoverableSpools.count) unsaved encounter spool(s)")
+        }
+    }
+    
     // MARK: - Model Management
     
     /// Search paths for models - expanded for iOS bundle and documents
@@ -125,6 +152,21 @@ final class TranscriptionEngine: ObservableObject {
             return
         }
         
+        // Predict resident memory from the model header before loading
+        var info = whisper_model_info()
+        if whisper_model_inspect_wrapper(modelPath, &info) == 0 {
+            let estimate = whisper_model_estimate_memory_wrapper(&info, 0)
+            let params = String(format: "%.0fM", Double(info.n_params) / 1e6)
+            print("🔎 Whisper \(stringFromCArray(info.model_type)) [\(stringFromCArray(info.dominant_type))]: \(params) params")
+            print("   Predicted memory: \(formatBytes(estimate.total_bytes)) (weights \(formatBytes(estimate.weights_bytes)), KV \(formatBytes(estimate.kv_cache_bytes)), compute \(formatBytes(estimate.compute_bytes)))")
+            
+            if let available = ProcessInfo.processInfo.availableMemoryBytes, estimate.total_bytes > available {
+                modelStatus = .error("Not enough memory for \(modelName): needs \(formatBytes(estimate.total_bytes)), \(formatBytes(available)) available")
+                print("❌ Skipping load - predicted memory exceeds available memory")
+                return
+            }
+        }
+        
         // Create context params
         guard let paramsPtr = whisper_context_default_params_by_ref_wrapper() else {
             modelStatus = .error("Failed to create context params - C library not initialized")
@@ -174,6 +216,15 @@ final class TranscriptionEngine: ObservableObject {
         let newSamples = (0..<frameLength).map { floatData[$0] }
         audioBuffer.append(contentsOf: newSamples)
         
+        // Spool raw audio to disk off the capture thread (batched writes, periodic fsync)
+        if let writer = spoolWriter {
+            spoolQueue.async {
+                newSamples.withUnsafeBufferPointer { samples in
+                    audio_spool_writer_append(writer, samples.baseAddress, Int32(samples.count))
+                }
+            }
+        }
+        
         // Process every 3 seconds of audio
         if audioBuffer.count >= 48000 {
             let chunk = Array(audioBuffer)
@@ -189,6 +240,206 @@ final class TranscriptionEngine: ObservableObject {
         }
     }
     
+    // MARK: - Audio Spool
+    
+    /// Directory holding encounter audio spools
+    static var spoolDirectory: URL? {
+        FileManager.default.urls(for: .applicationSupportDirectory, in: .userDomainMask)
+            .first?.appendingPathComponent("Spool", isDirectory: true)
+    }
+    
+    /// Create the spool directory, excluded from iCloud/iTunes backups (encounter audio is PHI)
+    private static func prepareSpoolDirectory() -> URL? {
+        guard var directory = spoolDirectory else { return nil }
+        try? FileManager.default.createDirectory(at: directory, withIntermediateDirectories: true)
+        
+        var values = URLResourceValues()
+        values.isExcludedFromBackup = true
+        try? directory.setResourceValues(values)
+        return directory
+    }
+    
+    /// Spool files on disk, oldest first
+    private static func listSpools() -> [URL] {
+        guard let directory = spoolDirectory,
+              let urls = try? FileManager.default.contentsOfDirectory(
+                at: directory,
+                includingPropertiesForKeys: [.creationDateKey]
+              ) else {
+            return []
+        }
+        
+        func created(_ url: URL) -> Date {
+            (try? url.resourceValues(forKeys: [.creationDateKey]).creationDate) ?? .distantPast
+        }
+        return urls.filter { $0.pathExtension == "hxspool" }.sorted { created($0) < created($1) }
+    }
+    
+    /// Delete spools older than the retention period
+    private func pruneSpools() {
+        let cutoff = Date().addingTimeInterval(-Double(Self.spoolRetentionDays) * 24 * 60 * 60)
+        for url in Self.listSpools() {
+            let created = (try? url.resourceValues(forKeys: [.creationDateKey]).creationDate) ?? .distantPast
+            if created < cutoff {
+                try? FileManager.default.removeItem(at: url)
+                print("🗑️ Deleted expired spool: \(url.lastPathComponent)")
+            }
+        }
+    }
+    
+    /// Start spooling captured audio to disk so it can be re-transcribed later
+    /// - Parameter encounterID: Identifier used for the spool file name
+    /// - Returns: URL of the spool file, or nil if it could not be created
+    @discardableResult
+    func startSpool(encounterID: UUID = UUID()) -> URL? {
+        finishSpool()
+        
+        // The previous encounter was never saved - keep it recoverable
+        if let previous = spoolURL, FileManager.default.fileExists(atPath: previous.path) {
+            recoverableSpools.append(previous)
+        }
+        spoolURL = nil
+        
+        guard let directory = Self.prepareSpoolDirectory() else { return nil }
+        
+        let url = directory.appendingPathComponent("\(encounterID.uuidString).hxspool")
+        
+        bufferLock.lock()
+        spoolWriter = audio_spool_writer_open(url.path, 0, 0)  // 1 s blocks, fsync every 5 s
+        bufferLock.unlock()
+        
+        guard spoolWriter != nil else {
+            print("❌ Failed to create audio spool at \(url.path)")
+            return nil
+        }
+        
+        // Encounter audio is PHI - keep it encrypted whenever the file is closed
+        try? FileManager.default.setAttributes(
+            [.protectionKey: FileProtectionType.completeUnlessOpen],
+            ofItemAtPath: url.path
+        )
+        
+        spoolURL = url
+        print("💾 Spooling audio to: \(url.lastPathComponent)")
+        return url
+    }
+    
+    /// Flush and close the current spool
+    func finishSpool() {
+        bufferLock.lock()
+        let writer = spoolWriter
+        spoolWriter = nil
+        bufferLock.unlock()
+        
+        if let writer = writer {
+            // Close behind any appends still queued for this writer
+            let seconds = spoolQueue.sync { () -> Double in
+                let seconds = Double(audio_spool_writer_n_samples(writer)) / Double(AUDIO_SPOOL_SAMPLE_RATE)
+                audio_spool_writer_close(writer)
+                return seconds
+            }
+            print("💾 Spool closed (\(String(format: "%.1f", seconds)) s of audio)")
+        }
+    }
+    
+    /// Delete the current encounter's spool once its note has been saved
+    func discardSpool() {
+        finishSpool()
+        guard let url = spoolURL else { return }
+        
+        try? FileManager.default.removeItem(at: url)
+        recoverableSpools.removeAll { $0 == url }
+        spoolURL = nil
+        print("🗑️ Spool deleted: \(url.lastPathComponent)")
+    }
+    
+    /// Delete a leftover spool without recovering it
+    func deleteSpool(at url: URL) {
+        try? FileManager.default.removeItem(at: url)
+        recoverableSpools.removeAll { $0 == url }
+    }
+    
+    /// Re-transcribe a leftover spool into the current transcript
+    /// The spool becomes the current one, so saving the note deletes it
+    /// - Parameter url: URL of the spool file
+    func recoverSpool(at url: URL) async {
+        let wasLoaded = isModelLoaded
+        if !wasLoaded {
+            await loadModel()
+        }
+        
+        let transcript = await transcribeSpool(at: url)
+        if !wasLoaded {
+            unloadModel()
+        }
+        guard !transcript.hasPrefix("Error:") else {
+            print("❌ Spool recovery failed: \(transcript)")
+            return
+        }
+        
+        finishSpool()
+        currentTranscript = transcript
+        spoolURL = url
+        recoverableSpools.removeAll { $0 == url }
+    }
+    
+    /// Re-transcribe a spooled encounter, e.g. with a larger model tier
+    /// - Parameter url: URL of the spool file
+    /// - Returns: The full transcription
+    func transcribeSpool(at url: URL) async -> String {
+        guard let ctx = whisperContext else {
+            return "Error: Model not loaded"
+        }
+        guard let reader = audio_spool_reader_open(url.path) else {
+            return "Error: Failed to open audio spool"
+        }
+        defer { audio_spool_reader_close(reader) }
+        
+        isTranscribing = true
+        defer { isTranscribing = false }
+        
+        guard let paramsPtr = whisper_full_default_params_by_ref_wrapper(WHISPER_SAMPLING_GREEDY) else {
+            return "Error: Failed to create params"
+        }
+        defer { whisper_free_params_wrapper(paramsPtr) }
+        
+        whisper_full_params_set_n_threads(paramsPtr, Int32(max(1, min(6, ProcessInfo.processInfo.processorCount - 2))))
+        whisper_full_params_set_language(paramsPtr, "en")
+        whisper_full_params_set_translate(paramsPtr, false)
+        whisper_full_params_set_no_context(paramsPtr, false)
+        whisper_full_params_set_single_segment(paramsPtr, false)
+        whisper_full_params_set_print_special(paramsPtr, false)
+        whisper_full_params_set_print_progress(paramsPtr, false)
+        whisper_full_params_set_print_realtime(paramsPtr, false)
+        whisper_full_params_set_print_timestamps(paramsPtr, false)
+        
+        // Feed Whisper its native 30 s windows straight from the mapped spool
+        let totalSamples = audio_spool_reader_n_samples(reader)
+        let windowSamples = Int64(AUDIO_SPOOL_SAMPLE_RATE) * 30
+        var transcription = ""
+        var offset: Int64 = 0
+        
+        print("🎙️ Re-transcribing \(totalSamples) spooled samples...")
+        
+        while offset < totalSamples {
+            let n = Int32(min(windowSamples, totalSamples - offset))
+            guard whisper_full_from_spool_wrapper(ctx, paramsPtr, reader, offset, n) == 0 else {
+                print("❌ Whisper transcription failed at sample \(offset)")
+                break
+            }
+            
+            let nSegments = whisper_full_n_segments_wrapper(ctx)
+            for i in 0..<nSegments {
+                if let text = whisper_full_get_segment_text_wrapper(ctx, i) {
+                    transcription += String(cString: text)
+                }
+            }
+            offset += Int64(n)
+        }
+        
+        return transcription
+    }
+    
     /// Process final audio buffer when recording stops
     func processFinalBuffer() async {
         bufferLock.lock()
@@ -230,6 +481,9 @@ final class TranscriptionEngine: ObservableObject {
         whisper_full_params_set_print_progress(paramsPtr, false)
         whisper_full_params_set_print_realtime(paramsPtr, false)
         whisper_full_params_set_print_timestamps(paramsPtr, true)
+        if adaptiveAudioContext {
+            whisper_full_params_set_adaptive_audio_ctx(paramsPtr, ctx, Int32(samples.count))
+        }
         
         print("🎙️ Transcribing \(samples.count) samples...")
         
@@ -317,5 +571,10 @@ final class TranscriptionEngine: ObservableObject {
         if let ctx = whisperContext {
             whisper_free_wrapper(ctx)
         }
+        if let writer = spoolWriter {
+            spoolQueue.sync {
+                audio_spool_writer_close(writer)
+            }
+        }
     }
 }
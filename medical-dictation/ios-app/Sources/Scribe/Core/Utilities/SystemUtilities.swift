@@ -0,0 +1,29 @@
+import Foundation
+import os
+
+// MARK: - Memory Budget
+
+extension ProcessInfo {
+    /// Memory the app can still allocate before the OS terminates it (nil where unknown)
+    var availableMemoryBytes: UInt64? {
+        #if os(iOS)
+        return UInt64(os_proc_available_memory())
+        #else
+        return nil
+        #endif
+    }
+}
+
+// MARK: - Formatting
+
+/// Format a byte count for logs and status messages
+func formatBytes(_ bytes: UInt64) -> String {
+    ByteCountFormatter.string(fromByteCount: Int64(clamping: bytes), countStyle: .memory)
+}
+
+/// Convert a fixed-size C char array (imported as a tuple) to a String
+func stringFromCArray<T>(_ array: T) -> String {
+    withUnsafeBytes(of: array) { raw in
+        String(decoding: raw.prefix(while: { $0 != 0 }), as: UTF8.self)
+    }
+}
@@ -65,6 +65,18 @@ final class HPTemplate {
             }
             return nil
         }
+        
+        /// Token budget for this section when generating an H&P note
+        var tokenBudget: Int32 {
+            switch self {
+            case .identifyingData, .chiefComplaint, .allergies: return 32
+            case .familyHistory: return 48
+            case .pastMedicalHistory, .medications, .socialHistory: return 64
+            case .assessment: return 96
+            case .reviewOfSystems, .plan: return 128
+            case .historyOfPresentIllness, .physicalExam: return 160
+            }
+        }
     }
     
     /// Voice cues that trigger section transitions
@@ -73,13 +73,15 @@ final class CustomTemplate {
     var systemPrompt: String
     var isBuiltIn: Bool
     var createdAt: Date
+    var loraAdapter: String? // Specialty LoRA adapter file name, applied on top of the base model
     
-    init(name: String, systemPrompt: String, isBuiltIn: Bool = false) {
+    init(name: String, systemPrompt: String, isBuiltIn: Bool = false, loraAdapter: String? = nil) {
         self.id = UUID()
         self.name = name
         self.systemPrompt = systemPrompt
         self.isBuiltIn = isBuiltIn
         self.createdAt = Date()
+        self.loraAdapter = loraAdapter
     }
     
     static let builtInTemplates: [CustomTemplate] = [
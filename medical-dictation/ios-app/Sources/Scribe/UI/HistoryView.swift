@@ -2,6 +2,7 @@ import SwiftUI
 import SwiftData
 
 struct HistoryView: View {
+    @EnvironmentObject var llmProcessor: LLMProcessor
     @Query(sort: \StructuredNote.encounterDate, order: .reverse) var notes: [StructuredNote]
     @State private var selectedNote: StructuredNote?
     @State private var searchText = ""
@@ -29,6 +30,30 @@ struct HistoryView: View {
             }
             .navigationTitle("History")
             .searchable(text: $searchText, prompt: "Search transcripts...")
+            .toolbar {
+                ToolbarItem(placement: .primaryAction) {
+                    Menu {
+                        Button {
+                            regenerate(template: nil)
+                        } label: {
+                            Label("Regenerate with Own Templates", systemImage: "arrow.clockwise")
+                        }
+                        
+                        Button {
+                            regenerate(template: llmProcessor.currentTemplate)
+                        } label: {
+                            Label("Regenerate as \(llmProcessor.currentTemplate.rawValue)", systemImage: "doc.badge.gearshape")
+                        }
+                    } label: {
+                        if llmProcessor.isProcessing {
+                            ProgressView()
+                        } else {
+                            Image(systemName: "arrow.triangle.2.circlepath")
+                        }
+                    }
+                    .disabled(!canRegenerate)
+                }
+            }
             .sheet(item: $selectedNote) { note in
                 NoteDetailView(note: note)
             }
@@ -44,6 +69,19 @@ struct HistoryView: View {
         }
     }
     
+    private var canRegenerate: Bool {
+        guard case .ready = llmProcessor.modelStatus else { return false }
+        return !llmProcessor.isProcessing && !filteredNotes.isEmpty
+    }
+    
+    /// Regenerate the listed notes from their transcripts in one batch
+    private func regenerate(template: LLMProcessor.NoteTemplate?) {
+        let targets = filteredNotes
+        Task {
+            await llmProcessor.regenerateNotes(targets, template: template)
+        }
+    }
+    
     private func deleteNotes(offsets: IndexSet) {
         // SwiftData handles deletion
     }
@@ -49,6 +49,11 @@ struct RecordingView: View {
                 AudioVisualizer(level: audioManager.audioLevel)
                     .frame(height: 60)
                 
+                // Encounter audio left behind by a crash or an unsaved note
+                if let spool = transcriptionEngine.recoverableSpools.first, !audioManager.isRecording {
+                    RecoverSpoolBanner(spoolURL: spool)
+                }
+                
                 // Live transcript
                 ScrollView {
                     Text(transcriptionEngine.currentTranscript.isEmpty ? 
@@ -90,7 +95,7 @@ struct RecordingView: View {
                             .font(.system(size: 32))
                             .foregroundColor(.blue)
                     }
-                    .disabled(transcriptionEngine.currentTranscript.isEmpty || {
+                    .disabled(transcriptionEngine.currentTranscript.isEmpty || llmProcessor.isProcessing || {
                         if case .ready = llmProcessor.modelStatus {
                             return false
                         }
@@ -112,6 +117,7 @@ struct RecordingView: View {
             // Process any remaining audio in the buffer
             Task {
                 await transcriptionEngine.processFinalBuffer()
+                transcriptionEngine.finishSpool()
                 // CRITICAL: Unload Whisper immediately after transcription to free memory
                 // This prevents iOS from killing the app when loading the LLM
                 print("🧹 Unloading Whisper to free memory for LLM...")
@@ -119,6 +125,8 @@ struct RecordingView: View {
             }
         } else {
             do {
+                // Keep the raw encounter audio for re-transcription and crash recovery
+                transcriptionEngine.startSpool()
                 try audioManager.startRecording()
                 // Wire audio to transcription
                 audioManager.onAudioBuffer = { buffer, time in
@@ -131,6 +139,52 @@ struct RecordingView: View {
     }
 }
 
+struct RecoverSpoolBanner: View {
+    let spoolURL: URL
+    @EnvironmentObject var transcriptionEngine: TranscriptionEngine
+    
+    @State private var isRecovering = false
+    
+    private var recordedAt: String {
+        let created = try? spoolURL.resourceValues(forKeys: [.creationDateKey]).creationDate
+        return created.map { $0.formatted(date: .abbreviated, time: .shortened) } ?? "an earlier session"
+    }
+    
+    var body: some View {
+        HStack {
+            Image(systemName: "waveform.badge.exclamationmark")
+                .foregroundColor(.orange)
+            Text("Unsaved recording from \(recordedAt)")
+                .font(.subheadline)
+            
+            Spacer()
+            
+            if isRecovering {
+                ProgressView()
+            } else {
+                Button("Recover") {
+                    isRecovering = true
+                    Task {
+                        await transcriptionEngine.recoverSpool(at: spoolURL)
+                        isRecovering = false
+                    }
+                }
+                .buttonStyle(.bordered)
+                
+                Button(role: .destructive) {
+                    transcriptionEngine.deleteSpool(at: spoolURL)
+                } label: {
+                    Image(systemName: "trash")
+                }
+            }
+        }
+        .padding()
+        .background(Color(.secondarySystemBackground))
+        .cornerRadius(12)
+        .padding(.horizontal)
+    }
+}
+
 struct RecordButton: View {
     let isRecording: Bool
     let action: () -> Void
@@ -255,6 +309,7 @@ struct StatusCard: View {
 struct ProcessSheet: View {
     let transcript: String
     @EnvironmentObject var llmProcessor: LLMProcessor
+    @EnvironmentObject var transcriptionEngine: TranscriptionEngine
     @Environment(\.dismiss) var dismiss
     
     @State private var selectedTemplate: LLMProcessor.NoteTemplate = .soap
@@ -277,6 +332,13 @@ struct ProcessSheet: View {
                         .scaleEffect(1.2)
                     Spacer()
                 } else if let note = generatedNote {
+                    if let warning = llmProcessor.adapterWarning {
+                        Label(warning, systemImage: "exclamationmark.triangle.fill")
+                            .font(.caption)
+                            .foregroundColor(.orange)
+                            .padding(.horizontal)
+                    }
+                    
                     ScrollView {
                         VStack(alignment: .leading, spacing: 16) {
                             ForEach(note.sections.sorted(by: { $0.key < $1.key }), id: \.key) { key, value in
@@ -295,6 +357,8 @@ struct ProcessSheet: View {
                     HStack {
                         Button("Save to History") {
                             // Save via SwiftData
+                            // The note now holds the encounter, so its audio is no longer needed
+                            transcriptionEngine.discardSpool()
                             dismiss()
                         }
                         .buttonStyle(.borderedProminent)
@@ -317,7 +381,8 @@ struct ProcessSheet: View {
                     }
                     .buttonStyle(.borderedProminent)
                     .disabled({
-                        if case .ready = llmProcessor.modelStatus {
+                        // A bulk regeneration may be using the model
+                        if case .ready = llmProcessor.modelStatus, !llmProcessor.isProcessing {
                             return false
                         }
                         return true
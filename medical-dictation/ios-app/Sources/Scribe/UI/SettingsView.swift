@@ -71,6 +71,8 @@ struct SettingsView: View {
                         Text("Maximum").tag(PerformanceTier.maximum)
                     }
                     .pickerStyle(.segmented)
+                    // Switching tiers reloads the model, which must not happen mid-generation
+                    .disabled(llmProcessor.isProcessing)
                     .onChange(of: selectedTier) { newTier in
                         Task {
                             // Reload both models with new tier
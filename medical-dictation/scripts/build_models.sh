@@ -8,6 +8,8 @@ SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
 BUILD_DIR="$SCRIPT_DIR/build"
 IOS_DEPLOYMENT_TARGET="17.0"
 
+source "$SCRIPT_DIR/deps.sh"
+
 echo "🏗️  Building Scribe Dependencies"
 echo "================================="
 
@@ -15,21 +17,9 @@ echo "================================="
 mkdir -p "$BUILD_DIR"
 cd "$BUILD_DIR"
 
-# Clone/update repositories
-clone_or_update() {
-    local repo=$1
-    local dir=$2
-    if [ -d "$dir" ]; then
-        echo "Updating $dir..."
-        cd "$dir" && git pull && cd ..
-    else
-        echo "Cloning $repo..."
-        git clone --depth 1 "$repo" "$dir"
-    fi
-}
-
-clone_or_update "https://github.com/ggerganov/whisper.cpp.git" "whisper.cpp"
-clone_or_update "https://github.com/ggerganov/llama.cpp.git" "llama.cpp"
+# Check out the pinned versions (see deps.sh)
+checkout_pinned "$WHISPER_CPP_REPO" "whisper.cpp" "$WHISPER_CPP_REF"
+checkout_pinned "$LLAMA_CPP_REPO" "llama.cpp" "$LLAMA_CPP_REF"
 
 # Build whisper.cpp for iOS
 echo ""
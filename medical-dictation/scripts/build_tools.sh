@@ -0,0 +1,94 @@
+#!/bin/bash
+# build_tools.sh - Build the host (macOS/Linux) command-line tools
+# Reuses the whisper.cpp/llama.cpp checkouts from build_models.sh and links the app's C wrappers
+
+set -e
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+BUILD_DIR="$SCRIPT_DIR/build"
+ROOT_DIR="$(dirname "$SCRIPT_DIR")"
+TOOLS_DIR="$ROOT_DIR/tools"
+OUT_DIR="$BUILD_DIR/tools"
+JOBS="$(getconf _NPROCESSORS_ONLN 2>/dev/null || echo 4)"
+
+source "$SCRIPT_DIR/deps.sh"
+
+echo "🛠️  Building Scribe Tools"
+echo "========================="
+
+mkdir -p "$BUILD_DIR" "$OUT_DIR"
+cd "$BUILD_DIR"
+
+# Same pinned versions as the app (see deps.sh)
+checkout_pinned "$WHISPER_CPP_REPO" "whisper.cpp" "$WHISPER_CPP_REF"
+checkout_pinned "$LLAMA_CPP_REPO" "llama.cpp" "$LLAMA_CPP_REF"
+
+# Build whisper.cpp for the host
+echo ""
+echo "📦 Building Whisper.cpp (host)..."
+cmake -S whisper.cpp -B whisper.cpp/build-host \
+    -DCMAKE_BUILD_TYPE=Release \
+    -DBUILD_SHARED_LIBS=OFF \
+    -DGGML_OPENMP=OFF \
+    -DWHISPER_BUILD_EXAMPLES=OFF \
+    -DWHISPER_BUILD_TESTS=OFF
+cmake --build whisper.cpp/build-host --config Release -j "$JOBS"
+
+# Build llama.cpp for the host
+echo ""
+echo "📦 Building Llama.cpp (host)..."
+cmake -S llama.cpp -B llama.cpp/build-host \
+    -DCMAKE_BUILD_TYPE=Release \
+    -DBUILD_SHARED_LIBS=OFF \
+    -DGGML_OPENMP=OFF \
+    -DLLAMA_CURL=OFF \
+    -DLLAMA_BUILD_EXAMPLES=OFF \
+    -DLLAMA_BUILD_TESTS=OFF \
+    -DLLAMA_BUILD_SERVER=OFF \
+    -DLLAMA_BUILD_TOOLS=OFF
+cmake --build llama.cpp/build-host --config Release -j "$JOBS"
+
+# Link flags for the static libraries of one checkout
+static_link() {
+    local libs
+    libs=$(find "$1/build-host" -name "*.a" | sort | tr '\n' ' ')
+    if [ "$(uname)" = "Darwin" ]; then
+        echo "$libs -lc++ -framework Accelerate -framework Foundation -framework Metal -framework MetalKit"
+    else
+        # GNU ld needs a group to resolve the cross-references between ggml archives
+        echo "-Wl,--start-group $libs -Wl,--end-group -lstdc++ -lm -lpthread"
+    fi
+}
+
+WHISPER_LINK=$(static_link whisper.cpp)
+LLAMA_LINK=$(static_link llama.cpp)
+
+# whisper_ctx_bench: encoder audio_ctx speed/accuracy sweep
+echo ""
+echo "⏱️  Building whisper_ctx_bench..."
+cc -O2 -std=c11 -D_GNU_SOURCE \
+    -I whisper.cpp/include -I whisper.cpp/ggml/include \
+    -I "$ROOT_DIR/ios-app/CWhisper/include" \
+    "$TOOLS_DIR/whisper_ctx_bench.c" \
+    "$ROOT_DIR/ios-app/CWhisper/whisper_wrapper.c" \
+    "$ROOT_DIR/ios-app/CWhisper/audio_spool.c" \
+    $WHISPER_LINK \
+    -o "$OUT_DIR/whisper_ctx_bench"
+
+# llama_batch_regen: continuous-batching note regeneration
+echo ""
+echo "📝 Building llama_batch_regen..."
+cc -O2 -std=c11 -D_GNU_SOURCE \
+    -I llama.cpp/include -I llama.cpp/ggml/include \
+    -I "$ROOT_DIR/ios-app/CLlama/include" \
+    "$TOOLS_DIR/llama_batch_regen.c" \
+    "$ROOT_DIR/ios-app/CLlama/llama_wrapper.c" \
+    $LLAMA_LINK \
+    -o "$OUT_DIR/llama_batch_regen"
+
+echo ""
+echo "✅ Tools built in $OUT_DIR"
+echo ""
+echo "Example:"
+echo "  $OUT_DIR/whisper_ctx_bench -m models/ggml-small.bin -f encounter.wav -c 3"
+echo "  $OUT_DIR/llama_batch_regen -m models/qwen2.5-7b-q4_k_m.gguf -s soap_prompt.txt -np 4 transcripts/*.txt"
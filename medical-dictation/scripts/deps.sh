@@ -0,0 +1,26 @@
+#!/bin/bash
+# deps.sh - Pinned whisper.cpp/llama.cpp versions, sourced by build_models.sh and build_tools.sh
+# The C wrappers in ios-app/ are written against these APIs - bump them together and rebuild both
+
+WHISPER_CPP_REPO="https://github.com/ggerganov/whisper.cpp.git"
+WHISPER_CPP_REF="${WHISPER_CPP_REF:-v1.7.6}"
+
+LLAMA_CPP_REPO="https://github.com/ggerganov/llama.cpp.git"
+LLAMA_CPP_REF="${LLAMA_CPP_REF:-b6200}"
+
+# Clone a repository at a pinned tag, or move an existing checkout to it
+checkout_pinned() {
+    local repo=$1
+    local dir=$2
+    local ref=$3
+    if [ -d "$dir/.git" ]; then
+        if [ "$(git -C "$dir" describe --tags --exact-match 2>/dev/null)" != "$ref" ]; then
+            echo "Checking out $dir at $ref..."
+            git -C "$dir" fetch --depth 1 origin tag "$ref"
+            git -C "$dir" checkout -q "$ref"
+        fi
+    else
+        echo "Cloning $repo at $ref..."
+        git clone --depth 1 --branch "$ref" "$repo" "$dir"
+    fi
+}
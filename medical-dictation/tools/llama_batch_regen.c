@@ -0,0 +1,257 @@
+//
+//  llama_batch_regen.c
+//  HxDictate
+//
+//  Regenerate notes for stored transcripts with continuous batching.
+//  Each transcript becomes one job; up to -np jobs are decoded together and a
+//  queued job is admitted as soon as another finishes. Prints per-job latency
+//  and aggregate throughput (run with -np 1 for the sequential baseline).
+//
+//  Usage:
+//    llama_batch_regen -m qwen2.5-7b-q4_k_m.gguf -s soap_prompt.txt
+//                      [--sections Subjective:256,Objective:192,Assessment:128,Plan:192]
+//                      [-np 4] [-c 0] [-n 1024] [-t 4] [-ngl 0] [-o notes/]
+//                      [--reasoning budget --reasoning-budget 256]
+//                      transcript1.txt transcript2.txt ...
+//
+
+#include "llama_wrapper.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_SECTIONS 32
+#define OUTPUT_BUFFER_SIZE 65536
+
+static char *load_text(const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return NULL;
+
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    char *text = (char *)malloc((size_t)size + 1);
+    if (text) {
+        size_t n = fread(text, 1, (size_t)size, f);
+        text[n] = '\0';
+    }
+    fclose(f);
+    return text;
+}
+
+/// Same ChatML layout as LLMProcessor.buildPrompt
+static char *build_prompt(const char *system_prompt, const char *transcript) {
+    const char *format = "<|im_start|>system\n%s<|im_end|>\n<|im_start|>user\n%s<|im_end|>\n<|im_start|>assistant\n";
+    size_t size = strlen(format) + strlen(system_prompt) + strlen(transcript) + 1;
+    char *prompt = (char *)malloc(size);
+    if (prompt) {
+        snprintf(prompt, size, format, system_prompt, transcript);
+    }
+    return prompt;
+}
+
+/// Parse "Header:budget,Header:budget" (budgets optional)
+static int parse_sections(char *spec, struct llama_note_section *sections) {
+    int n = 0;
+    for (char *tok = strtok(spec, ","); tok && n < MAX_SECTIONS; tok = strtok(NULL, ",")) {
+        char *colon = strrchr(tok, ':');
+        sections[n].max_tokens = 0;
+        if (colon) {
+            *colon = '\0';
+            sections[n].max_tokens = atoi(colon + 1);
+        }
+        sections[n].header = tok;
+        n++;
+    }
+    return n;
+}
+
+static bool parse_reasoning(const char *name, enum llama_reasoning_mode *mode) {
+    if (strcmp(name, "keep") == 0) *mode = LLAMA_REASONING_KEEP;
+    else if (strcmp(name, "suppress") == 0) *mode = LLAMA_REASONING_SUPPRESS;
+    else if (strcmp(name, "budget") == 0) *mode = LLAMA_REASONING_BUDGET;
+    else if (strcmp(name, "strip") == 0) *mode = LLAMA_REASONING_STRIP;
+    else return false;
+    return true;
+}
+
+static const char *base_name(const char *path) {
+    const char *slash = strrchr(path, '/');
+    return slash ? slash + 1 : path;
+}
+
+static bool on_job_done(int32_t job_index, const struct llama_batch_job *job, void *user_data) {
+    const char **paths = (const char **)user_data;
+    const char *status = job->status == LLAMA_BATCH_JOB_DONE ? "done" : "FAILED";
+    double t_gen_s = job->stats.t_generate_ms / 1000.0;
+
+    printf("%-28.28s %-6s %7d %7d %9.0f %9.0f %8.1f\n",
+           base_name(paths[job_index]), status,
+           job->stats.n_prompt_tokens, job->stats.n_generated_tokens,
+           job->t_wait_ms, job->t_latency_ms,
+           t_gen_s > 0 ? job->stats.n_generated_tokens / t_gen_s : 0.0);
+    fflush(stdout);
+    return true;
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr,
+            "usage: %s -m MODEL -s SYSTEM_PROMPT [--sections SPEC] [-np N] [-c N_CTX] [-n MAX_TOKENS]\n"
+            "          [-t THREADS] [-ngl GPU_LAYERS] [-o OUT_DIR] [--reasoning MODE] [--reasoning-budget N]\n"
+            "          TRANSCRIPT...\n"
+            "  --sections  Header:budget list, e.g. Subjective:256,Objective:192,Assessment:128,Plan:192\n"
+            "  -np         parallel sequences (default 4)\n"
+            "  -c          total KV cells shared by all sequences (default 2048 per sequence)\n"
+            "  --reasoning keep, suppress, budget or strip (default keep; Maximum tier uses budget/256)\n"
+            "  --reasoning-budget  think tokens for --reasoning budget (default 256)\n",
+            argv0);
+}
+
+int main(int argc, char **argv) {
+    const char *model_path = NULL, *system_path = NULL, *out_dir = NULL;
+    char *sections_spec = NULL;
+    int n_parallel = 4, n_ctx = 0, max_tokens = 1024, n_threads = 4, n_gpu_layers = 0;
+    enum llama_reasoning_mode reasoning = LLAMA_REASONING_KEEP;
+    int reasoning_budget = 256;
+    const char **transcript_paths = (const char **)calloc((size_t)argc, sizeof(char *));
+    int n_jobs = 0;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        if (arg[0] != '-') {
+            transcript_paths[n_jobs++] = arg;
+            continue;
+        }
+
+        const char *val = i + 1 < argc ? argv[++i] : NULL;
+        if (!val) { usage(argv[0]); return 1; }
+
+        if (strcmp(arg, "-m") == 0) model_path = val;
+        else if (strcmp(arg, "-s") == 0) system_path = val;
+        else if (strcmp(arg, "-o") == 0) out_dir = val;
+        else if (strcmp(arg, "--sections") == 0) sections_spec = strdup(val);
+        else if (strcmp(arg, "-np") == 0) n_parallel = atoi(val);
+        else if (strcmp(arg, "-c") == 0) n_ctx = atoi(val);
+        else if (strcmp(arg, "-n") == 0) max_tokens = atoi(val);
+        else if (strcmp(arg, "-t") == 0) n_threads = atoi(val);
+        else if (strcmp(arg, "-ngl") == 0) n_gpu_layers = atoi(val);
+        else if (strcmp(arg, "--reasoning-budget") == 0) reasoning_budget = atoi(val);
+        else if (strcmp(arg, "--reasoning") == 0) {
+            if (!parse_reasoning(val, &reasoning)) { usage(argv[0]); return 1; }
+        }
+        else { usage(argv[0]); return 1; }
+    }
+    if (!model_path || !system_path || n_jobs == 0 || n_parallel <= 0 || max_tokens <= 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    char *system_prompt = load_text(system_path);
+    if (!system_prompt) {
+        fprintf(stderr, "error: failed to read %s\n", system_path);
+        return 1;
+    }
+
+    struct llama_note_section sections[MAX_SECTIONS];
+    int n_sections = sections_spec ? parse_sections(sections_spec, sections) : 0;
+    struct llama_generation_options options = {
+        .sections = n_sections > 0 ? sections : NULL,
+        .n_sections = n_sections,
+        .reasoning = reasoning,
+        .reasoning_budget = reasoning_budget
+    };
+
+    // Build the job queue
+    struct llama_batch_job *jobs = (struct llama_batch_job *)calloc((size_t)n_jobs, sizeof(*jobs));
+    for (int j = 0; j < n_jobs; j++) {
+        char *transcript = load_text(transcript_paths[j]);
+        if (!transcript) {
+            fprintf(stderr, "error: failed to read %s\n", transcript_paths[j]);
+            return 1;
+        }
+        jobs[j].prompt = build_prompt(system_prompt, transcript);
+        jobs[j].max_tokens = max_tokens;
+        jobs[j].options = n_sections > 0 || reasoning != LLAMA_REASONING_KEEP ? &options : NULL;
+        jobs[j].output_buffer = (char *)malloc(OUTPUT_BUFFER_SIZE);
+        jobs[j].output_buffer_size = OUTPUT_BUFFER_SIZE;
+        free(transcript);
+    }
+
+    // Load model
+    llama_wrapper_backend_init();
+
+    struct llama_model *model = llama_wrapper_load_model(model_path, n_gpu_layers, NULL, NULL);
+    if (!model) {
+        fprintf(stderr, "error: failed to load model %s\n", model_path);
+        return 1;
+    }
+
+    struct llama_context *ctx = llama_wrapper_new_batch_context(model, (uint32_t)n_ctx, (uint32_t)n_parallel,
+                                                                n_threads, n_threads);
+    if (!ctx) {
+        fprintf(stderr, "error: failed to create context\n");
+        return 1;
+    }
+    struct llama_vocab *vocab = llama_wrapper_get_vocab(model);
+
+    // Estimate with the context actually created (-c 0 means 2048 cells per sequence)
+    struct llama_model_info info;
+    if (llama_wrapper_inspect_model(model_path, &info, NULL, 0) == 0) {
+        struct llama_memory_estimate estimate = llama_wrapper_estimate_memory(&info, llama_wrapper_n_ctx(ctx), (uint32_t)n_parallel);
+        printf("model: %s [%s, %s], %.1fB params, ~%.0f MiB with KV cache\n",
+               info.name, info.architecture, info.dominant_type, info.n_params / 1e9,
+               estimate.total_bytes / (1024.0 * 1024.0));
+    }
+
+    printf("jobs: %d, parallel sequences: %d, KV cells: %u\n\n", n_jobs, n_parallel, llama_wrapper_n_ctx(ctx));
+    printf("%-28s %-6s %7s %7s %9s %9s %8s\n", "transcript", "status", "prompt", "gen", "wait ms", "latency", "tok/s");
+
+    struct llama_sampler_config config = llama_wrapper_default_sampler_config();
+    config.seed = 42;
+
+    struct llama_batch_run_stats stats = {0};
+    int32_t result = llama_wrapper_run_batch_jobs(ctx, vocab, jobs, n_jobs, config,
+                                                  on_job_done, transcript_paths, &stats);
+    if (result < 0) {
+        fprintf(stderr, "error: batch run failed after %d jobs\n", stats.n_jobs_done);
+    }
+
+    printf("\n%d done, %d failed in %.1f s (%d decode calls)\n",
+           stats.n_jobs_done, stats.n_jobs_failed, stats.t_total_ms / 1000.0, stats.n_decode_calls);
+    printf("throughput: %.1f prompt tok/s, %.1f generated tok/s, %.2f jobs/min\n",
+           stats.prompt_tokens_per_s, stats.generated_tokens_per_s,
+           stats.t_total_ms > 0 ? stats.n_jobs_done * 60000.0 / stats.t_total_ms : 0.0);
+
+    // Write each note to the output directory
+    if (out_dir) {
+        for (int j = 0; j < n_jobs; j++) {
+            if (jobs[j].status != LLAMA_BATCH_JOB_DONE) continue;
+
+            char path[4096];
+            snprintf(path, sizeof(path), "%s/%s.note.txt", out_dir, base_name(transcript_paths[j]));
+            FILE *f = fopen(path, "w");
+            if (!f) {
+                fprintf(stderr, "error: failed to write %s\n", path);
+                continue;
+            }
+            fputs(jobs[j].output_buffer, f);
+            fclose(f);
+        }
+    }
+
+    for (int j = 0; j < n_jobs; j++) {
+        free((char *)jobs[j].prompt);
+        free(jobs[j].output_buffer);
+    }
+    free(jobs);
+    free(system_prompt);
+    free(sections_spec);
+    free(transcript_paths);
+
+    llama_wrapper_free_context(ctx);
+    llama_wrapper_free_model(model);
+    llama_wrapper_backend_free();
+    return result < 0 ? 1 : 0;
+}
@@ -0,0 +1,374 @@
+//
+//  whisper_ctx_bench.c
+//  HxDictate
+//
+//  Benchmark of encoder audio_ctx against speed and accuracy for streaming chunks.
+//  Splits a recording into chunks the way TranscriptionEngine does, transcribes it
+//  once per audio_ctx setting and reports time per chunk, real-time factor and WER
+//  against a reference (a reference transcript, or the full 30 s window).
+//
+//  Usage:
+//    whisper_ctx_bench -m ggml-small.bin -f encounter.wav [-c 3] [-t 4]
+//                      [-a full,768,512,384,256,adaptive] [-r reference.txt]
+//
+//  Audio must be 16 kHz mono PCM16 WAV, or an .hxspool file from the app.
+//
+
+#include "whisper.h"
+#include "whisper_wrapper.h"
+#include "audio_spool.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MAX_SETTINGS 16
+#define ADAPTIVE -1
+
+// MARK: - Audio Loading
+
+static float *load_wav(const char *path, int *n_samples) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return NULL;
+
+    char riff[12];
+    if (fread(riff, 1, 12, f) != 12 || memcmp(riff, "RIFF", 4) != 0 || memcmp(riff + 8, "WAVE", 4) != 0) {
+        fclose(f);
+        return NULL;
+    }
+
+    uint16_t format = 0, channels = 0, bits = 0;
+    uint32_t rate = 0;
+    float *samples = NULL;
+
+    // Walk chunks until the data chunk
+    char id[4];
+    uint32_t size;
+    while (fread(id, 1, 4, f) == 4 && fread(&size, 4, 1, f) == 1) {
+        if (memcmp(id, "fmt ", 4) == 0) {
+            uint8_t fmt[16];
+            if (size < 16 || fread(fmt, 1, 16, f) != 16) break;
+            memcpy(&format, fmt, 2);
+            memcpy(&channels, fmt + 2, 2);
+            memcpy(&rate, fmt + 4, 4);
+            memcpy(&bits, fmt + 14, 2);
+            fseek(f, (long)(size - 16 + (size & 1)), SEEK_CUR);
+        } else if (memcmp(id, "data", 4) == 0) {
+            if (format != 1 || channels != 1 || bits != 16 || rate != AUDIO_SPOOL_SAMPLE_RATE) {
+                fprintf(stderr, "error: expected 16 kHz mono PCM16 WAV (got %u Hz, %u ch, %u bit)\n", rate, channels, bits);
+                break;
+            }
+            int n = (int)(size / 2);
+            int16_t *pcm = (int16_t *)malloc((size_t)n * sizeof(int16_t));
+            samples = (float *)malloc((size_t)n * sizeof(float));
+            if (pcm && samples && fread(pcm, 2, (size_t)n, f) == (size_t)n) {
+                audio_spool_pcm16_to_float(pcm, samples, (size_t)n);
+                *n_samples = n;
+            } else {
+                free(samples);
+                samples = NULL;
+            }
+            free(pcm);
+            break;
+        } else {
+            fseek(f, (long)(size + (size & 1)), SEEK_CUR);
+        }
+    }
+
+    fclose(f);
+    return samples;
+}
+
+static float *load_spool(const char *path, int *n_samples) {
+    struct audio_spool_reader *reader = audio_spool_reader_open(path);
+    if (!reader) return NULL;
+
+    int n = (int)audio_spool_reader_n_samples(reader);
+    float *samples = (float *)malloc((size_t)n * sizeof(float));
+    if (samples) {
+        *n_samples = audio_spool_reader_read(reader, 0, n, samples);
+    }
+
+    audio_spool_reader_close(reader);
+    return samples;
+}
+
+static char *load_text(const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return NULL;
+
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    char *text = (char *)malloc((size_t)size + 1);
+    if (text) {
+        size_t n = fread(text, 1, (size_t)size, f);
+        text[n] = '\0';
+    }
+    fclose(f);
+    return text;
+}
+
+// MARK: - Word Error Rate
+
+/// Split text into lowercase words, dropping punctuation
+static int split_words(const char *text, char ***words_out) {
+    int cap = 256, n = 0;
+    char **words = (char **)malloc((size_t)cap * sizeof(char *));
+    char word[128];
+    int len = 0;
+
+    for (const char *c = text;; c++) {
+        if (*c && (isalnum((unsigned char)*c) || *c == '\'')) {
+            if (len < (int)sizeof(word) - 1) word[len++] = (char)tolower((unsigned char)*c);
+            continue;
+        }
+        if (len > 0) {
+            if (n == cap) {
+                cap *= 2;
+                words = (char **)realloc(words, (size_t)cap * sizeof(char *));
+            }
+            word[len] = '\0';
+            words[n++] = strdup(word);
+            len = 0;
+        }
+        if (!*c) break;
+    }
+
+    *words_out = words;
+    return n;
+}
+
+static void free_words(char **words, int n) {
+    for (int i = 0; i < n; i++) free(words[i]);
+    free(words);
+}
+
+/// Word-level edit distance divided by the reference length
+static double word_error_rate(const char *reference, const char *hypothesis) {
+    char **ref, **hyp;
+    int n_ref = split_words(reference, &ref);
+    int n_hyp = split_words(hypothesis, &hyp);
+
+    int *prev = (int *)malloc((size_t)(n_hyp + 1) * sizeof(int));
+    int *cur = (int *)malloc((size_t)(n_hyp + 1) * sizeof(int));
+    for (int j = 0; j <= n_hyp; j++) prev[j] = j;
+
+    for (int i = 1; i <= n_ref; i++) {
+        cur[0] = i;
+        for (int j = 1; j <= n_hyp; j++) {
+            int sub = prev[j - 1] + (strcmp(ref[i - 1], hyp[j - 1]) != 0);
+            int del = prev[j] + 1;
+            int ins = cur[j - 1] + 1;
+            cur[j] = sub < del ? (sub < ins ? sub : ins) : (del < ins ? del : ins);
+        }
+        int *tmp = prev;
+        prev = cur;
+        cur = tmp;
+    }
+
+    double wer = n_ref > 0 ? (double)prev[n_hyp] / n_ref : (n_hyp > 0 ? 1.0 : 0.0);
+
+    free(prev);
+    free(cur);
+    free_words(ref, n_ref);
+    free_words(hyp, n_hyp);
+    return wer;
+}
+
+// MARK: - Benchmark
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+static void silent_log(enum ggml_log_level level, const char *text, void *user_data) {
+    (void)level;
+    (void)text;
+    (void)user_data;
+}
+
+/// Transcribe the recording in chunks with one audio_ctx setting
+/// @return Malloc'd transcript (NULL on error); total encode+decode time in *elapsed_ms
+static char *run_setting(struct whisper_context *ctx, int n_threads, int audio_ctx,
+                         const float *samples, int n_samples, int chunk_samples, double *elapsed_ms) {
+    size_t cap = 4096, len = 0;
+    char *text = (char *)calloc(cap, 1);
+    *elapsed_ms = 0;
+
+    for (int offset = 0; offset < n_samples; offset += chunk_samples) {
+        int n = n_samples - offset < chunk_samples ? n_samples - offset : chunk_samples;
+
+        // Same settings as TranscriptionEngine's streaming path
+        struct whisper_full_params *params = whisper_full_default_params_by_ref_wrapper(WHISPER_SAMPLING_GREEDY);
+        whisper_full_params_set_n_threads(params, n_threads);
+        whisper_full_params_set_language(params, "en");
+        whisper_full_params_set_no_context(params, true);
+        whisper_full_params_set_print_progress(params, false);
+        whisper_full_params_set_print_realtime(params, false);
+        whisper_full_params_set_print_timestamps(params, false);
+        if (audio_ctx == ADAPTIVE) {
+            whisper_full_params_set_adaptive_audio_ctx(params, ctx, n);
+        } else {
+            whisper_full_params_set_audio_ctx(params, audio_ctx);
+        }
+
+        double start = now_ms();
+        int result = whisper_full_wrapper(ctx, params, samples + offset, n);
+        *elapsed_ms += now_ms() - start;
+        whisper_free_params_wrapper(params);
+
+        if (result != 0) {
+            free(text);
+            return NULL;
+        }
+
+        for (int i = 0; i < whisper_full_n_segments_wrapper(ctx); i++) {
+            const char *segment = whisper_full_get_segment_text_wrapper(ctx, i);
+            size_t seg_len = strlen(segment);
+            if (len + seg_len + 2 > cap) {
+                cap = (len + seg_len + 2) * 2;
+                text = (char *)realloc(text, cap);
+            }
+            memcpy(text + len, segment, seg_len);
+            len += seg_len;
+            text[len++] = ' ';
+            text[len] = '\0';
+        }
+    }
+
+    return text;
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr,
+            "usage: %s -m MODEL -f AUDIO [-c CHUNK_SEC] [-t THREADS] [-a SETTINGS] [-r REFERENCE] [-v]\n"
+            "  -a  comma-separated audio_ctx values, 'full' or 'adaptive' (default: full,768,512,384,256,adaptive)\n"
+            "  -r  reference transcript (default: the first setting's output)\n",
+            argv0);
+}
+
+int main(int argc, char **argv) {
+    const char *model_path = NULL, *audio_path = NULL, *ref_path = NULL;
+    const char *settings_arg = "full,768,512,384,256,adaptive";
+    double chunk_sec = 3.0;
+    int n_threads = 4;
+    int verbose = 0;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *val = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(arg, "-v") == 0) { verbose = 1; continue; }
+        if (!val) { usage(argv[0]); return 1; }
+
+        if (strcmp(arg, "-m") == 0) model_path = val;
+        else if (strcmp(arg, "-f") == 0) audio_path = val;
+        else if (strcmp(arg, "-r") == 0) ref_path = val;
+        else if (strcmp(arg, "-a") == 0) settings_arg = val;
+        else if (strcmp(arg, "-c") == 0) chunk_sec = atof(val);
+        else if (strcmp(arg, "-t") == 0) n_threads = atoi(val);
+        else { usage(argv[0]); return 1; }
+        i++;
+    }
+    if (!model_path || !audio_path || chunk_sec <= 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    // Parse settings
+    int settings[MAX_SETTINGS], n_settings = 0;
+    char *settings_copy = strdup(settings_arg);
+    for (char *tok = strtok(settings_copy, ","); tok && n_settings < MAX_SETTINGS; tok = strtok(NULL, ",")) {
+        if (strcmp(tok, "full") == 0) settings[n_settings++] = 0;
+        else if (strcmp(tok, "adaptive") == 0) settings[n_settings++] = ADAPTIVE;
+        else settings[n_settings++] = atoi(tok);
+    }
+    free(settings_copy);
+
+    // Load audio
+    int n_samples = 0;
+    size_t path_len = strlen(audio_path);
+    bool is_spool = path_len > 8 && strcmp(audio_path + path_len - 8, ".hxspool") == 0;
+    float *samples = is_spool ? load_spool(audio_path, &n_samples) : load_wav(audio_path, &n_samples);
+    if (!samples || n_samples <= 0) {
+        fprintf(stderr, "error: failed to load audio from %s\n", audio_path);
+        return 1;
+    }
+
+    // Load model
+    if (!verbose) whisper_log_set(silent_log, NULL);
+
+    struct whisper_model_info info;
+    if (whisper_model_inspect_wrapper(model_path, &info) == 0) {
+        printf("model: %s (%s), %.0fM params\n", info.model_type, info.dominant_type, info.n_params / 1e6);
+    }
+
+    struct whisper_context_params *cparams = whisper_context_default_params_by_ref_wrapper();
+    struct whisper_context *ctx = whisper_init_from_file_with_params_wrapper(model_path, cparams);
+    whisper_free_context_params_wrapper(cparams);
+    if (!ctx) {
+        fprintf(stderr, "error: failed to load model %s\n", model_path);
+        return 1;
+    }
+
+    int chunk_samples = (int)(chunk_sec * AUDIO_SPOOL_SAMPLE_RATE);
+    int n_chunks = (n_samples + chunk_samples - 1) / chunk_samples;
+    double audio_ms = n_samples * 1000.0 / AUDIO_SPOOL_SAMPLE_RATE;
+    printf("audio: %.1f s in %d chunks of %.1f s, %d threads\n\n", audio_ms / 1000.0, n_chunks, chunk_sec, n_threads);
+
+    // Warm up so graph allocation is not charged to the first setting
+    double warmup_ms;
+    free(run_setting(ctx, n_threads, 0, samples, chunk_samples < n_samples ? chunk_samples : n_samples,
+                     chunk_samples, &warmup_ms));
+
+    char *reference = ref_path ? load_text(ref_path) : NULL;
+    double baseline_ms = 0;
+
+    printf("%-16s %10s %8s %8s %8s\n", "audio_ctx", "ms/chunk", "RTF", "speedup", "WER");
+    for (int s = 0; s < n_settings; s++) {
+        double elapsed_ms;
+        char *text = run_setting(ctx, n_threads, settings[s], samples, n_samples, chunk_samples, &elapsed_ms);
+        if (!text) {
+            fprintf(stderr, "error: transcription failed for setting %d\n", settings[s]);
+            continue;
+        }
+
+        char label[32];
+        if (settings[s] == ADAPTIVE) {
+            snprintf(label, sizeof(label), "adaptive (%d)", whisper_adaptive_audio_ctx_wrapper(ctx, chunk_samples));
+        } else if (settings[s] == 0) {
+            snprintf(label, sizeof(label), "full (%d)", info.n_audio_ctx);
+        } else {
+            snprintf(label, sizeof(label), "%d", settings[s]);
+        }
+
+        if (baseline_ms == 0) baseline_ms = elapsed_ms;
+
+        char wer[16];
+        if (reference) {
+            snprintf(wer, sizeof(wer), "%.1f%%", 100.0 * word_error_rate(reference, text));
+        } else {
+            snprintf(wer, sizeof(wer), "ref");
+        }
+
+        printf("%-16s %10.1f %8.3f %7.2fx %8s\n", label, elapsed_ms / n_chunks, elapsed_ms / audio_ms,
+               baseline_ms / elapsed_ms, wer);
+        if (verbose) printf("  %s\n", text);
+
+        if (reference) {
+            free(text);
+        } else {
+            reference = text;
+        }
+    }
+
+    free(reference);
+    free(samples);
+    whisper_free_wrapper(ctx);
+    return 0;
+}